@@ -0,0 +1,324 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compiled-filter.h"
+
+#include <QtCore/QDebug>
+
+#include <QtContacts/QContactIdFilter>
+#include <QtContacts/QContactDetailFilter>
+#include <QtContacts/QContactUnionFilter>
+#include <QtContacts/QContactIntersectionFilter>
+#include <QtContacts/QContactChangeLogFilter>
+#include <QtContacts/QContactManagerEngine>
+#include <QtContacts/QContactPhoneNumber>
+
+using namespace QtContacts;
+
+namespace galera
+{
+
+CompiledFilter::CompiledFilter()
+{
+}
+
+CompiledFilter::CompiledFilter(const QContactFilter &filter)
+{
+    compile(filter);
+}
+
+bool CompiledFilter::test(const QContact &contact,
+                          const QDateTime &deletedDate,
+                          const QList<ParsedPhoneNumber> *phoneNumbers) const
+{
+    if (m_program.isEmpty()) {
+        return false;
+    }
+    return evaluate(0, contact, deletedDate, phoneNumbers);
+}
+
+int CompiledFilter::size() const
+{
+    return m_program.size();
+}
+
+void CompiledFilter::compile(const QContactFilter &filter)
+{
+    int pc = m_program.size();
+    m_program.append(Instruction());
+    Instruction instruction;
+    instruction.operation = MatchEngine;
+    instruction.detailType = QContactDetail::TypeUndefined;
+    instruction.detailField = -1;
+    instruction.caseSensitivity = Qt::CaseInsensitive;
+
+    switch(filter.type()) {
+    case QContactFilter::DefaultFilter:
+        instruction.operation = MatchAll;
+        break;
+
+    case QContactFilter::InvalidFilter:
+        instruction.operation = MatchNone;
+        break;
+
+    case QContactFilter::IdFilter:
+    {
+        const QContactIdFilter idf(filter);
+        instruction.operation = MatchIds;
+        instruction.ids = idf.ids().toSet();
+        break;
+    }
+
+    case QContactFilter::ChangeLogFilter:
+    {
+        const QContactChangeLogFilter clf(filter);
+        if (clf.eventType() == QContactChangeLogFilter::EventRemoved) {
+            instruction.operation = MatchRemovedSince;
+            instruction.since = clf.since();
+        } else {
+            instruction.filter = filter;
+        }
+        break;
+    }
+
+    case QContactFilter::ContactDetailFilter:
+        compileDetailFilter(filter, &instruction);
+        break;
+
+    case QContactFilter::IntersectionFilter:
+    {
+        instruction.operation = MatchIntersection;
+        const QContactIntersectionFilter cif(filter);
+        Q_FOREACH(const QContactFilter &f, sortByCost(cif.filters())) {
+            compile(f);
+        }
+        break;
+    }
+
+    case QContactFilter::UnionFilter:
+    {
+        instruction.operation = MatchUnion;
+        const QContactUnionFilter uf(filter);
+        Q_FOREACH(const QContactFilter &f, sortByCost(uf.filters())) {
+            compile(f);
+        }
+        break;
+    }
+
+    default:
+        instruction.filter = filter;
+        break;
+    }
+
+    instruction.end = m_program.size();
+    m_program[pc] = instruction;
+}
+
+void CompiledFilter::compileDetailFilter(const QContactFilter &filter, Instruction *instruction)
+{
+    const QContactDetailFilter cdf(filter);
+    instruction->detailType = cdf.detailType();
+    instruction->detailField = cdf.detailField();
+    instruction->matchFlags = cdf.matchFlags();
+
+    if (cdf.detailType() == QContactDetail::TypeUndefined) {
+        instruction->operation = MatchNone;
+    } else if (cdf.detailField() == -1) {
+        // just testing for the presence of a detail of the specified type
+        instruction->operation = MatchDetailPresence;
+    } else if (cdf.matchFlags() & QContactFilter::MatchPhoneNumber) {
+        // the query is normalized and parsed only once
+        instruction->operation = MatchPhoneNumber;
+        instruction->phoneNumber = ParsedPhoneNumber(cdf.value().toString());
+    } else if ((cdf.value().type() == QVariant::String) &&
+               !(cdf.matchFlags() & QContactFilter::MatchKeypadCollation) &&
+               (cdf.matchFlags() & (QContactFilter::MatchContains |
+                                    QContactFilter::MatchStartsWith |
+                                    QContactFilter::MatchEndsWith |
+                                    QContactFilter::MatchFixedString))) {
+        // plain string comparison, the same done by QContactManagerEngine::testFilter
+        instruction->operation = MatchString;
+        instruction->value = cdf.value().toString();
+        instruction->caseSensitivity = (cdf.matchFlags() & QContactFilter::MatchCaseSensitive) ?
+                    Qt::CaseSensitive : Qt::CaseInsensitive;
+    } else {
+        instruction->filter = filter;
+    }
+}
+
+// Rough cost to test a filter against one contact, the terms of unions and intersections
+// are evaluated from the cheapest to the most expensive since the result does not depend on the order
+int CompiledFilter::cost(const QContactFilter &filter)
+{
+    switch(filter.type()) {
+    case QContactFilter::DefaultFilter:
+    case QContactFilter::InvalidFilter:
+        return 0;
+    case QContactFilter::IdFilter:
+    case QContactFilter::ChangeLogFilter:
+        return 1;
+    case QContactFilter::ContactDetailFilter:
+    {
+        const QContactDetailFilter cdf(filter);
+        if (cdf.detailField() == -1) {
+            return 2;
+        } else if (cdf.matchFlags() & QContactFilter::MatchPhoneNumber) {
+            // normalization and libphonenumber matching for each number
+            return 32;
+        } else if (cdf.value().type() == QVariant::String) {
+            return 4;
+        }
+        return 8;
+    }
+    case QContactFilter::IntersectionFilter:
+    case QContactFilter::UnionFilter:
+    {
+        const QList<QContactFilter> terms = (filter.type() == QContactFilter::UnionFilter ?
+                                             QContactUnionFilter(filter).filters() :
+                                             QContactIntersectionFilter(filter).filters());
+        int result = 1;
+        Q_FOREACH(const QContactFilter &f, terms) {
+            result += cost(f);
+        }
+        return result;
+    }
+    default:
+        return 16;
+    }
+}
+
+QList<QContactFilter> CompiledFilter::sortByCost(const QList<QContactFilter> &filters)
+{
+    QList<QPair<int, int> > costs;
+    for (int i = 0; i < filters.size(); i++) {
+        costs << qMakePair(cost(filters.at(i)), i);
+    }
+    qStableSort(costs);
+
+    QList<QContactFilter> result;
+    for (int i = 0; i < costs.size(); i++) {
+        result << filters.at(costs.at(i).second);
+    }
+    return result;
+}
+
+bool CompiledFilter::evaluate(int pc,
+                              const QContact &contact,
+                              const QDateTime &deletedDate,
+                              const QList<ParsedPhoneNumber> *phoneNumbers) const
+{
+    const Instruction &instruction = m_program.at(pc);
+
+    switch(instruction.operation) {
+    case MatchAll:
+        return true;
+
+    case MatchNone:
+        return false;
+
+    case MatchIntersection:
+    {
+        // an empty intersection does not match anything
+        if ((pc + 1) == instruction.end) {
+            return false;
+        }
+        for (int operand = pc + 1; operand < instruction.end; operand = m_program.at(operand).end) {
+            if (!evaluate(operand, contact, deletedDate, phoneNumbers)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    case MatchUnion:
+        for (int operand = pc + 1; operand < instruction.end; operand = m_program.at(operand).end) {
+            if (evaluate(operand, contact, deletedDate, phoneNumbers)) {
+                return true;
+            }
+        }
+        return false;
+
+    case MatchIds:
+        return instruction.ids.contains(contact.id());
+
+    case MatchRemovedSince:
+        return (deletedDate >= instruction.since);
+
+    case MatchDetailPresence:
+        return !contact.details(instruction.detailType).isEmpty();
+
+    case MatchPhoneNumber:
+        return testPhoneNumbers(instruction, contact, phoneNumbers);
+
+    case MatchString:
+        return testDetails(instruction, contact);
+
+    case MatchEngine:
+        return QContactManagerEngine::testFilter(instruction.filter, contact);
+    }
+
+    return false;
+}
+
+bool CompiledFilter::testDetails(const Instruction &instruction, const QContact &contact) const
+{
+    const QList<QContactDetail> details = contact.details(instruction.detailType);
+    bool matchStarts = (instruction.matchFlags & 7) == QContactFilter::MatchStartsWith;
+    bool matchEnds = (instruction.matchFlags & 7) == QContactFilter::MatchEndsWith;
+    bool matchContains = (instruction.matchFlags & 7) == QContactFilter::MatchContains;
+
+    const Qt::CaseSensitivity cs = instruction.caseSensitivity;
+
+    Q_FOREACH(const QContactDetail &detail, details) {
+        const QString value = detail.value(instruction.detailField).toString();
+        if ((matchStarts && value.startsWith(instruction.value, cs)) ||
+            (matchEnds && value.endsWith(instruction.value, cs)) ||
+            (matchContains && value.contains(instruction.value, cs)) ||
+            (QString::compare(value, instruction.value, cs) == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompiledFilter::testPhoneNumbers(const Instruction &instruction,
+                                      const QContact &contact,
+                                      const QList<ParsedPhoneNumber> *phoneNumbers) const
+{
+    // use the numbers cached by the contact if the filter is about the phone number field
+    if (phoneNumbers &&
+        (instruction.detailType == QContactDetail::TypePhoneNumber) &&
+        (instruction.detailField == QContactPhoneNumber::FieldNumber)) {
+        Q_FOREACH(const ParsedPhoneNumber &number, *phoneNumbers) {
+            if (instruction.phoneNumber.match(number, instruction.matchFlags)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Q_FOREACH(const QContactDetail &detail, contact.details(instruction.detailType)) {
+        ParsedPhoneNumber number(detail.value(instruction.detailField).toString());
+        if (instruction.phoneNumber.match(number, instruction.matchFlags)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_COMPILED_FILTER_H__
+#define __GALERA_COMPILED_FILTER_H__
+
+#include "parsed-phone-number.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include <QtContacts/QContact>
+#include <QtContacts/QContactFilter>
+#include <QtContacts/QContactId>
+
+namespace galera
+{
+
+// Flat representation of a QContactFilter tree. The tree is walked only once and
+// the values used by each test (detail type/field, match flags, normalized phone
+// numbers, id sets) are resolved before any contact is tested.
+class CompiledFilter
+{
+public:
+    CompiledFilter();
+    CompiledFilter(const QtContacts::QContactFilter &filter);
+
+    // 'phoneNumbers' are the numbers of the contact already parsed, if they are not
+    // available the numbers will be parsed from the contact details
+    bool test(const QtContacts::QContact &contact,
+              const QDateTime &deletedDate = QDateTime(),
+              const QList<ParsedPhoneNumber> *phoneNumbers = 0) const;
+    int size() const;
+
+    static int cost(const QtContacts::QContactFilter &filter);
+
+private:
+    enum Operation {
+        MatchAll = 0,
+        MatchNone,
+        // the operands are the instructions between this one and 'end'
+        MatchIntersection,
+        MatchUnion,
+        MatchIds,
+        MatchRemovedSince,
+        MatchDetailPresence,
+        MatchPhoneNumber,
+        MatchString,
+        // anything else is handled by QContactManagerEngine
+        MatchEngine
+    };
+
+    class Instruction
+    {
+    public:
+        Operation operation;
+        // index of the first instruction after this one and its operands
+        int end;
+        QtContacts::QContactDetail::DetailType detailType;
+        int detailField;
+        QtContacts::QContactFilter::MatchFlags matchFlags;
+        Qt::CaseSensitivity caseSensitivity;
+        QString value;
+        ParsedPhoneNumber phoneNumber;
+        QDateTime since;
+        QSet<QtContacts::QContactId> ids;
+        QtContacts::QContactFilter filter;
+    };
+
+    QVector<Instruction> m_program;
+
+    void compile(const QtContacts::QContactFilter &filter);
+    void compileDetailFilter(const QtContacts::QContactFilter &filter, Instruction *instruction);
+    bool evaluate(int pc,
+                  const QtContacts::QContact &contact,
+                  const QDateTime &deletedDate,
+                  const QList<ParsedPhoneNumber> *phoneNumbers) const;
+    bool testDetails(const Instruction &instruction, const QtContacts::QContact &contact) const;
+    bool testPhoneNumbers(const Instruction &instruction,
+                          const QtContacts::QContact &contact,
+                          const QList<ParsedPhoneNumber> *phoneNumbers) const;
+
+    static QList<QtContacts::QContactFilter> sortByCost(const QList<QtContacts::QContactFilter> &filters);
+};
+
+}
+
+#endif
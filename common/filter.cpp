@@ -36,8 +36,6 @@
 #include <QtContacts/QContactIdFilter>
 #include <QtContacts/QContactRelationshipFilter>
 
-#include <phonenumbers/phonenumberutil.h>
-
 using namespace QtContacts;
 
 namespace galera
@@ -46,11 +44,15 @@ namespace galera
 Filter::Filter(const QString &filter)
 {
     m_filter = buildFilter(filter);
+    m_program = CompiledFilter(m_filter);
+    m_includeRemoved = includeRemoved();
 }
 
 Filter::Filter(const QtContacts::QContactFilter &filter)
 {
     m_filter = parseFilter(filter);
+    m_program = CompiledFilter(m_filter);
+    m_includeRemoved = includeRemoved();
 }
 
 QString Filter::toString() const
@@ -63,160 +65,15 @@ QtContacts::QContactFilter Filter::toContactFilter() const
     return m_filter;
 }
 
-bool Filter::test(const QContact &contact, const QDateTime &deletedDate) const
+bool Filter::test(const QContact &contact,
+                  const QDateTime &deletedDate,
+                  const QList<ParsedPhoneNumber> *phoneNumbers) const
 {
-    if (deletedDate.isValid() && !includeRemoved()) {
+    if (deletedDate.isValid() && !m_includeRemoved) {
         return false;
     }
 
-    return testFilter(m_filter, contact, deletedDate);
-}
-
-bool Filter::testFilter(const QContactFilter& filter,
-                        const QContact &contact,
-                        const QDateTime &deletedDate)
-{
-    switch(filter.type()) {
-        case QContactFilter::IdFilter:
-            return QContactManagerEngine::testFilter(filter, contact);
-
-        case QContactFilter::ChangeLogFilter:
-        {
-            const QContactChangeLogFilter bf(filter);
-            if (bf.eventType() == QContactChangeLogFilter::EventRemoved) {
-                return (deletedDate >= bf.since());
-            } else if (QContactManagerEngine::testFilter(filter, contact)) {
-                return true;
-            }
-            break;
-        }
-
-        case QContactFilter::ContactDetailFilter:
-        {
-            const QContactDetailFilter cdf(filter);
-            if (cdf.detailType() == QContactDetail::TypeUndefined)
-                return false;
-
-            /* See if this contact has one of these details in it */
-            const QList<QContactDetail>& details = contact.details(cdf.detailType());
-
-            if (details.count() == 0)
-                return false; /* can't match */
-
-            /* See if we need to check the values */
-            if (cdf.detailField() == -1)
-                return true;  /* just testing for the presence of a detail of the specified type */
-
-            if (cdf.matchFlags() & QContactFilter::MatchPhoneNumber) {
-                /* Doing phone number filtering.  We hand roll an implementation here, backends will obviously want to override this. */
-                QString input = cdf.value().toString();
-
-                /* Look at every detail in the set of details and compare */
-                for (int j = 0; j < details.count(); j++) {
-                    const QContactDetail& detail = details.at(j);
-                    const QString& valueString = detail.value(cdf.detailField()).toString();
-
-                    if (comparePhoneNumbers(input, valueString, cdf.matchFlags())) {
-                        return true;
-                    }
-                }
-            } else if (QContactManagerEngine::testFilter(cdf, contact)) {
-                return true;
-            }
-            break;
-        }
-
-        case QContactFilter::IntersectionFilter:
-        {
-            /* XXX In theory we could reorder the terms to put the native tests first */
-            const QContactIntersectionFilter bf(filter);
-            const QList<QContactFilter>& terms = bf.filters();
-
-            if (terms.isEmpty()) {
-                break;
-            }
-
-           Q_FOREACH(const QContactFilter &f, terms) {
-                if (!testFilter(f, contact, deletedDate)) {
-                    return false;
-                }
-            }
-            return true;
-        }
-        break;
-
-        case QContactFilter::UnionFilter:
-        {
-            /* XXX In theory we could reorder the terms to put the native tests first */
-            const QContactUnionFilter bf(filter);
-            const QList<QContactFilter>& terms = bf.filters();
-            if (terms.count() > 0) {
-                for(int j = 0; j < terms.count(); j++) {
-                    if (testFilter(terms.at(j), contact, deletedDate)) {
-                        return true;
-                    }
-                }
-                return false;
-            }
-            // Fall through to end
-        }
-        break;
-
-        default:
-            if (QContactManagerEngine::testFilter(filter, contact)) {
-                return true;
-            }
-            break;
-
-    }
-
-    return false;
-}
-
-bool Filter::comparePhoneNumbers(const QString &input, const QString &value, QContactFilter::MatchFlags flags)
-{
-    static i18n::phonenumbers::PhoneNumberUtil *phonenumberUtil = i18n::phonenumbers::PhoneNumberUtil::GetInstance();
-
-    std::string stdPreprocessedInput(input.toStdString());
-    std::string stdProcessedValue(value.toStdString());
-
-    phonenumberUtil->NormalizeDiallableCharsOnly(&stdPreprocessedInput);
-    phonenumberUtil->NormalizeDiallableCharsOnly(&stdProcessedValue);
-
-    QString preprocessedInput = QString::fromStdString(stdPreprocessedInput);
-    QString preprocessedValue = QString::fromStdString(stdProcessedValue);
-
-    // if one of they does not contain digits return false
-    if (preprocessedInput.isEmpty() || preprocessedValue.isEmpty()) {
-        return false;
-    }
-
-    bool mc = flags & QContactFilter::MatchContains;
-    bool msw = flags & QContactFilter::MatchStartsWith;
-    bool mew = flags & QContactFilter::MatchEndsWith;
-    bool me = flags & QContactFilter::MatchExactly;
-    if (!mc && !msw && !mew && !me &&
-        ((preprocessedInput.length() < 6) || (preprocessedValue.length() < 6))) {
-        return preprocessedInput == preprocessedValue;
-    }
-
-    if (mc) {
-        return preprocessedValue.contains(preprocessedInput);
-    } else if (msw) {
-        return preprocessedValue.startsWith(preprocessedInput);
-    } else if (mew) {
-        return preprocessedValue.endsWith(preprocessedInput);
-    } else {
-        i18n::phonenumbers::PhoneNumberUtil::MatchType match =
-                phonenumberUtil->IsNumberMatchWithTwoStrings(input.toStdString(),
-                                                             value.toStdString());
-        if (me) {
-            return match == i18n::phonenumbers::PhoneNumberUtil::EXACT_MATCH;
-        } else {
-            return match > i18n::phonenumbers::PhoneNumberUtil::NO_MATCH;
-        }
-    }
-    return false;
+    return m_program.test(contact, deletedDate, phoneNumbers);
 }
 
 bool Filter::checkIsValid(const QList<QContactFilter> filters) const
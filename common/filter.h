@@ -19,6 +19,8 @@
 #ifndef __GALERA_FILTER_H__
 #define __GALERA_FILTER_H__
 
+#include "compiled-filter.h"
+
 #include <QtCore/QDateTime>
 #include <QtContacts/QContactFilter>
 #include <QtContacts/QContact>
@@ -35,7 +37,9 @@ public:
 
     QString toString() const;
     QtContacts::QContactFilter toContactFilter() const;
-    bool test(const QtContacts::QContact &contact, const QDateTime &deletedDate = QDateTime()) const;
+    bool test(const QtContacts::QContact &contact,
+              const QDateTime &deletedDate = QDateTime(),
+              const QList<ParsedPhoneNumber> *phoneNumbers = 0) const;
     bool isValid() const;
     bool isEmpty() const;
     bool includeRemoved() const;
@@ -46,6 +50,9 @@ public:
 
 private:
     QtContacts::QContactFilter m_filter;
+    // flat version of m_filter used to test contacts
+    CompiledFilter m_program;
+    bool m_includeRemoved;
 
     Filter();
 
@@ -65,8 +72,6 @@ private:
     static QtContacts::QContactFilter parseFilter(const QtContacts::QContactFilter &filter);
     static QtContacts::QContactFilter parseUnionFilter(const QtContacts::QContactFilter &filter);
     static QtContacts::QContactFilter parseIntersectionFilter(const QtContacts::QContactFilter &filter);
-    static bool testFilter(const QtContacts::QContactFilter& filter, const QtContacts::QContact &contact, const QDateTime &deletedDate);
-    static bool comparePhoneNumbers(const QString &phoneNumberA, const QString &phoneNumberB, QtContacts::QContactFilter::MatchFlags flags);
 };
 
 }
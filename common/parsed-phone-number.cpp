@@ -0,0 +1,127 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "parsed-phone-number.h"
+
+#include <phonenumbers/phonenumberutil.h>
+#include <phonenumbers/region_code.h>
+
+using namespace QtContacts;
+using namespace i18n::phonenumbers;
+
+namespace galera
+{
+
+ParsedPhoneNumber::ParsedPhoneNumber()
+    : m_parseError(PhoneNumberUtil::NOT_A_NUMBER)
+{
+}
+
+ParsedPhoneNumber::ParsedPhoneNumber(const QString &number)
+    : m_number(number),
+      m_normalized(normalize(number)),
+      m_parseError(PhoneNumberUtil::NOT_A_NUMBER)
+{
+    if (!m_normalized.isEmpty()) {
+        PhoneNumber *parsed = new PhoneNumber;
+        m_parseError = PhoneNumberUtil::GetInstance()->Parse(number.toStdString(),
+                                                             RegionCode::GetUnknown(),
+                                                             parsed);
+        if (m_parseError == PhoneNumberUtil::NO_PARSING_ERROR) {
+            m_parsed = QSharedPointer<PhoneNumber>(parsed);
+        } else {
+            delete parsed;
+        }
+    }
+}
+
+QString ParsedPhoneNumber::number() const
+{
+    return m_number;
+}
+
+QString ParsedPhoneNumber::normalized() const
+{
+    return m_normalized;
+}
+
+bool ParsedPhoneNumber::match(const ParsedPhoneNumber &value, QContactFilter::MatchFlags flags) const
+{
+    // if one of they does not contain digits return false
+    if (m_normalized.isEmpty() || value.m_normalized.isEmpty()) {
+        return false;
+    }
+
+    bool mc = flags & QContactFilter::MatchContains;
+    bool msw = flags & QContactFilter::MatchStartsWith;
+    bool mew = flags & QContactFilter::MatchEndsWith;
+    bool me = flags & QContactFilter::MatchExactly;
+    if (!mc && !msw && !mew && !me &&
+        ((m_normalized.length() < 6) || (value.m_normalized.length() < 6))) {
+        return m_normalized == value.m_normalized;
+    }
+
+    if (mc) {
+        return value.m_normalized.contains(m_normalized);
+    } else if (msw) {
+        return value.m_normalized.startsWith(m_normalized);
+    } else if (mew) {
+        return value.m_normalized.endsWith(m_normalized);
+    } else {
+        int match = matchType(value);
+        if (me) {
+            return match == PhoneNumberUtil::EXACT_MATCH;
+        } else {
+            return match > PhoneNumberUtil::NO_MATCH;
+        }
+    }
+    return false;
+}
+
+// Same result as PhoneNumberUtil::IsNumberMatchWithTwoStrings(number(), value.number()) but
+// reusing the numbers already parsed, the strings are only parsed again for numbers without
+// country code, since they need the region of the other number
+int ParsedPhoneNumber::matchType(const ParsedPhoneNumber &value) const
+{
+    static PhoneNumberUtil *phonenumberUtil = PhoneNumberUtil::GetInstance();
+
+    if (m_parsed) {
+        if (value.m_parsed) {
+            return phonenumberUtil->IsNumberMatch(*m_parsed, *value.m_parsed);
+        }
+        return phonenumberUtil->IsNumberMatchWithOneString(*m_parsed, value.m_number.toStdString());
+    }
+
+    if ((m_parseError == PhoneNumberUtil::INVALID_COUNTRY_CODE_ERROR) && value.m_parsed) {
+        return phonenumberUtil->IsNumberMatchWithOneString(*value.m_parsed, m_number.toStdString());
+    }
+
+    return phonenumberUtil->IsNumberMatchWithTwoStrings(m_number.toStdString(),
+                                                        value.m_number.toStdString());
+}
+
+QString ParsedPhoneNumber::normalize(const QString &number)
+{
+    static PhoneNumberUtil *phonenumberUtil = PhoneNumberUtil::GetInstance();
+
+    std::string stdNumber(number.toStdString());
+    phonenumberUtil->NormalizeDiallableCharsOnly(&stdNumber);
+    return QString::fromStdString(stdNumber);
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_PARSED_PHONE_NUMBER_H__
+#define __GALERA_PARSED_PHONE_NUMBER_H__
+
+#include <QtCore/QString>
+#include <QtCore/QSharedPointer>
+
+#include <QtContacts/QContactFilter>
+
+namespace i18n {
+namespace phonenumbers {
+class PhoneNumber;
+}
+}
+
+namespace galera
+{
+
+// Phone number normalized and parsed by libphonenumber only once. Contacts keep a list of
+// these for its numbers and filters for the query, this way comparing two numbers does
+// not need to normalize or parse any string again.
+class ParsedPhoneNumber
+{
+public:
+    ParsedPhoneNumber();
+    ParsedPhoneNumber(const QString &number);
+
+    QString number() const;
+    // number with diallable chars only
+    QString normalized() const;
+
+    // check if 'value' matches this number using the same rules of a
+    // QContactDetailFilter with QContactFilter::MatchPhoneNumber flag
+    bool match(const ParsedPhoneNumber &value, QtContacts::QContactFilter::MatchFlags flags) const;
+
+    static QString normalize(const QString &number);
+
+private:
+    QString m_number;
+    QString m_normalized;
+    // i18n::phonenumbers::PhoneNumberUtil::ErrorType
+    int m_parseError;
+    QSharedPointer<i18n::phonenumbers::PhoneNumber> m_parsed;
+
+    int matchType(const ParsedPhoneNumber &value) const;
+};
+
+}
+
+#endif
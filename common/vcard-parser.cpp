@@ -17,16 +17,20 @@
  */
 
 #include "vcard-parser.h"
+#include "vcard-tokenizer.h"
+#include "vcard-writer.h"
 
 #include <QtCore/QMimeDatabase>
 #include <QtCore/QMimeType>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 
 #include <QtVersit/QVersitDocument>
-#include <QtVersit/QVersitWriter>
-#include <QtVersit/QVersitReader>
 #include <QtVersit/QVersitContactExporter>
 #include <QtVersit/QVersitContactImporter>
 #include <QtVersit/QVersitProperty>
+#include <QtVersit/QVersitReader>
 
 #include <QtContacts/QContactDetail>
 #include <QtContacts/QContactExtendedDetail>
@@ -295,28 +299,77 @@ const QMap<QtContacts::QContactDetail::DetailType, QString> VCardParser::Preferr
 
 VCardParser::VCardParser(QObject *parent)
     : QObject(parent),
-      m_versitWriter(0),
-      m_versitReader(0)
+      m_exportTask(0),
+      m_importing(false),
+      m_exporting(false)
 {
-    m_exporterHandler = new ContactExporterDetailHandler;
     m_importerHandler = new ContactImporterPropertyHandler;
 }
 
 VCardParser::~VCardParser()
 {
     waitForFinished();
+    delete m_exportTask;
 
-    delete m_exporterHandler;
     delete m_importerHandler;
  }
 
-QList<QContact> VCardParser::vcardToContactSync(const QStringList &vcardList)
+// the tokenizer only reads the vCard 3.0 dialect written by the service, the vCards
+// sent by the clients can use encodings and properties that only QVersitReader supports
+static bool isTokenizerSupported(const QString &vcard)
+{
+    return vcard.contains(QLatin1String("\nVERSION:3.0"), Qt::CaseInsensitive) &&
+           !vcard.contains(QLatin1String("QUOTED-PRINTABLE"), Qt::CaseInsensitive) &&
+           !vcard.contains(QLatin1String("CHARSET="), Qt::CaseInsensitive) &&
+           !vcard.contains(QLatin1String("\nAGENT"), Qt::CaseInsensitive);
+}
+
+static QList<QVersitDocument> readDocuments(const QStringList &vcardList)
+{
+    QList<QVersitDocument> documents;
+    QStringList tokenizerVcards;
+    Q_FOREACH(const QString &vcard, vcardList) {
+        if (isTokenizerSupported(vcard)) {
+            tokenizerVcards << vcard;
+            continue;
+        }
+
+        // keep the vCards order
+        documents += VCardTokenizer::parse(tokenizerVcards);
+        tokenizerVcards.clear();
+
+        QVersitReader reader(vcard.toUtf8());
+        reader.startReading();
+        reader.waitForFinished();
+        if (reader.error() != QVersitReader::NoError) {
+            qWarning() << "Fail to read vcard" << reader.error();
+        }
+        documents += reader.results();
+    }
+    documents += VCardTokenizer::parse(tokenizerVcards);
+    return documents;
+}
+
+static bool importContacts(const QStringList &vcardList,
+                           QVersitContactImporterPropertyHandlerV2 *handler,
+                           QList<QContact> *contacts)
 {
-    VCardParser parser;
-    parser.vcardToContact(vcardList);
-    parser.waitForFinished();
+    QVersitContactImporter importer;
+    importer.setPropertyHandler(handler);
+    if (!importer.importDocuments(readDocuments(vcardList))) {
+        qWarning() << "Fail to import contacts";
+        return false;
+    }
+    *contacts = importer.contacts();
+    return true;
+}
 
-    return parser.contactsResult();
+QList<QContact> VCardParser::vcardToContactSync(const QStringList &vcardList)
+{
+    ContactImporterPropertyHandler handler;
+    QList<QContact> contacts;
+    importContacts(vcardList, &handler, &contacts);
+    return contacts;
 }
 
 QtContacts::QContact VCardParser::vcardToContact(const QString &vcard)
@@ -326,53 +379,36 @@ QtContacts::QContact VCardParser::vcardToContact(const QString &vcard)
 
 void VCardParser::vcardToContact(const QStringList &vcardList)
 {
-    if (m_versitReader) {
+    if (m_importing) {
         qWarning() << "Import operation in progress.";
         return;
     }
     m_vcardsResult.clear();
     m_contactsResult.clear();
 
-    QString vcards = vcardList.join("\r\n");
-    m_versitReader = new QVersitReader(vcards.toUtf8());
-    connect(m_versitReader,
-            SIGNAL(resultsAvailable()),
-            SLOT(onReaderResultsAvailable()));
-    connect(m_versitReader,
-            SIGNAL(stateChanged(QVersitReader::State)),
-            SLOT(onReaderStateChanged(QVersitReader::State)));
-    m_versitReader->startReading();
+    if (!importContacts(vcardList, m_importerHandler, &m_contactsResult)) {
+        return;
+    }
+
+    // the result is delivered asynchronously as the callers expect
+    m_importing = true;
+    QMetaObject::invokeMethod(this, "onImportFinished", Qt::QueuedConnection);
 }
 
 void VCardParser::cancel()
 {
-    if (m_versitReader) {
-        m_versitReader->disconnect(this);
-        m_versitReader->cancel();
-        m_versitReader->deleteLater();
-        m_versitReader = 0;
-    }
-
-    if (m_versitWriter) {
-        m_versitWriter->disconnect(this);
-        m_versitWriter->cancel();
-        m_versitWriter->deleteLater();
-        m_versitWriter = 0;
-    }
+    m_importing = false;
+    m_exporting = false;
 
     Q_EMIT canceled();
 }
 
 void VCardParser::waitForFinished()
 {
-    if (m_versitReader) {
-        m_versitReader->waitForFinished();
+    if (m_exportTask) {
+        m_exportTask->wait();
     }
-    if (m_versitWriter) {
-        m_versitWriter->waitForFinished();
-    }
-
-    // wait state changed events to arrive
+    // wait the import and export results to arrive
     QCoreApplication::sendPostedEvents(this);
 }
 
@@ -386,11 +422,6 @@ QList<QContact> VCardParser::contactsResult() const
     return m_contactsResult;
 }
 
-void VCardParser::onReaderResultsAvailable()
-{
-    //NOTHING FOR NOW
-}
-
 QStringList VCardParser::splitVcards(const QByteArray &vcardList)
 {
     QStringList result;
@@ -410,66 +441,111 @@ QStringList VCardParser::splitVcards(const QByteArray &vcardList)
     return result;
 }
 
-void VCardParser::onReaderStateChanged(QVersitReader::State state)
+void VCardParser::onImportFinished()
 {
-    if (m_versitReader && (state == QVersitReader::FinishedState)) {
-        QList<QVersitDocument> documents = m_versitReader->results();
-
-        QVersitContactImporter contactImporter;
-        contactImporter.setPropertyHandler(m_importerHandler);
-        if (!contactImporter.importDocuments(documents)) {
-            qWarning() << "Fail to import contacts";
-            return;
-        }
-        m_contactsResult = contactImporter.contacts();
-        Q_EMIT contactsParsed(contactImporter.contacts());
+    if (m_importing) {
+        m_importing = false;
+        Q_EMIT contactsParsed(m_contactsResult);
+    }
+}
 
-        delete m_versitReader;
-        m_versitReader = 0;
+static QStringList exportContacts(const QList<QContact> &contacts,
+                                  QVersitContactExporterDetailHandlerV2 *handler)
+{
+    QVersitContactExporter exporter;
+    exporter.setDetailHandler(handler);
+    if (!exporter.exportContacts(contacts, QVersitDocument::VCard30Type)) {
+        qWarning() << "Fail to export contacts" << exporter.errors();
+        return QStringList();
     }
+
+    VCardWriter writer;
+    return writer.write(exporter.documents());
 }
 
+// export the contacts out of the caller thread, the result is delivered on the parser thread
+class ExportContactsTask : public QRunnable
+{
+public:
+    ExportContactsTask(VCardParser *parser, const QList<QContact> &contacts)
+        : m_parser(parser),
+          m_contacts(contacts),
+          m_finished(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void wait()
+    {
+        if (!m_finished) {
+            m_done.acquire();
+            m_finished = true;
+        }
+    }
+
+    QStringList result() const
+    {
+        return m_result;
+    }
+
+    void run()
+    {
+        // the handler does not keep state, each thread uses its own
+        ContactExporterDetailHandler handler;
+        m_result = exportContacts(m_contacts, &handler);
+        m_contacts.clear();
+        // the queued call is discarded if the parser is destroyed after wait()
+        QMetaObject::invokeMethod(m_parser, "onExportFinished", Qt::QueuedConnection);
+        m_done.release();
+    }
+
+private:
+    VCardParser *m_parser;
+    QList<QContact> m_contacts;
+    QStringList m_result;
+    QSemaphore m_done;
+    bool m_finished;
+};
+
 void VCardParser::contactToVcard(QList<QtContacts::QContact> contacts)
 {
-    if (m_versitWriter) {
+    if (m_exporting) {
         qWarning() << "Export operation in progress.";
         return;
     }
     m_vcardsResult.clear();
     m_contactsResult.clear();
 
-    QVersitContactExporter exporter;
-    exporter.setDetailHandler(m_exporterHandler);
-    if (!exporter.exportContacts(contacts, QVersitDocument::VCard30Type)) {
-        qWarning() << "Fail to export contacts" << exporter.errors();
-        return;
-    }
+    // a canceled export may still be running
+    waitForFinished();
 
-    m_versitWriter = new QVersitWriter(&m_vcardData);
-    connect(m_versitWriter,
-            SIGNAL(stateChanged(QVersitWriter::State)),
-            SLOT(onWriterStateChanged(QVersitWriter::State)));
-    m_versitWriter->startWriting(exporter.documents());
+    m_exporting = true;
+    m_exportTask = new ExportContactsTask(this, contacts);
+    QThreadPool::globalInstance()->start(m_exportTask);
 }
 
-void VCardParser::onWriterStateChanged(QVersitWriter::State state)
+void VCardParser::onExportFinished()
 {
-    if (state == QVersitWriter::FinishedState) {
-        QStringList vcards = VCardParser::splitVcards(m_vcardData);
+    if (!m_exportTask) {
+        return;
+    }
+
+    m_exportTask->wait();
+    QStringList vcards = m_exportTask->result();
+    delete m_exportTask;
+    m_exportTask = 0;
+
+    if (m_exporting) {
+        m_exporting = false;
         m_vcardsResult = vcards;
-        Q_EMIT vcardParsed(vcards);
-        delete m_versitWriter;
-        m_versitWriter = 0;
+        Q_EMIT vcardParsed(m_vcardsResult);
     }
 }
 
 QStringList VCardParser::contactToVcardSync(QList<QContact> contacts)
 {
-    VCardParser parser;
-    parser.contactToVcard(contacts);
-    parser.waitForFinished();
-
-    return parser.vcardResult();
+    ContactExporterDetailHandler handler;
+    return exportContacts(contacts, &handler);
 }
 
 QString VCardParser::contactToVcard(const QContact &contact)
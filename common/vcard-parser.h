@@ -25,7 +25,6 @@
 
 #include <QtContacts/QtContacts>
 
-#include <QtVersit/QVersitWriter>
 #include <QtVersit/QVersitReader>
 #include <QtVersit/QVersitResourceHandler>
 #include <QtVersit/QVersitContactExporterDetailHandlerV2>
@@ -36,6 +35,8 @@ namespace galera
 
 using namespace QtVersit;
 
+class ExportContactsTask;
+
 class VCardParser : public QObject
 {
     Q_OBJECT
@@ -73,19 +74,18 @@ Q_SIGNALS:
     void canceled();
 
 private Q_SLOTS:
-    void onWriterStateChanged(QVersitWriter::State state);
-    void onReaderStateChanged(QVersitReader::State state);
-    void onReaderResultsAvailable();
+    void onImportFinished();
+    void onExportFinished();
 
 private:
-    QtVersit::QVersitWriter *m_versitWriter;
-    QtVersit::QVersitReader *m_versitReader;
-    QtVersit::QVersitContactExporterDetailHandlerV2 *m_exporterHandler;
     QtVersit::QVersitContactImporterPropertyHandlerV2 *m_importerHandler;
 
-    QByteArray m_vcardData;
     QStringList m_vcardsResult;
     QList<QtContacts::QContact> m_contactsResult;
+    // export running on the thread pool
+    ExportContactsTask *m_exportTask;
+    bool m_importing;
+    bool m_exporting;
 };
 
 }
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vcard-tokenizer.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+
+using namespace QtVersit;
+
+namespace
+{
+    // same value types used by QVersitReader for vCard 3.0
+    QHash<QString, QVersitProperty::ValueType> valueTypes()
+    {
+        QHash<QString, QVersitProperty::ValueType> types;
+
+        types.insert(QStringLiteral("N"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("ADR"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("GEO"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("ORG"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("X-NOKIA-QCONTACTFIELD"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("X-QTPROJECT-EXTENDED-DETAIL"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("X-QTPROJECT-FAVORITE"), QVersitProperty::CompoundType);
+        types.insert(QStringLiteral("CATEGORIES"), QVersitProperty::ListType);
+        types.insert(QStringLiteral("NICKNAME"), QVersitProperty::ListType);
+        types.insert(QStringLiteral("X-NICKNAME"), QVersitProperty::ListType);
+
+        return types;
+    }
+
+    // return the next physical line without the line break
+    QStringRef takeLine(const QString &data, int *pos)
+    {
+        int start = *pos;
+        int end = data.indexOf(QLatin1Char('\n'), start);
+        if (end < 0) {
+            end = data.size();
+        }
+        *pos = end + 1;
+
+        if ((end > start) && (data.at(end - 1) == QLatin1Char('\r'))) {
+            end--;
+        }
+        return data.midRef(start, end - start);
+    }
+
+    bool isFolded(const QString &data, int pos)
+    {
+        return ((pos < data.size()) &&
+                ((data.at(pos) == QLatin1Char(' ')) || (data.at(pos) == QLatin1Char('\t'))));
+    }
+}
+
+namespace galera
+{
+
+QList<QVersitDocument> VCardTokenizer::parse(const QStringList &vcards)
+{
+    QList<QVersitDocument> documents;
+    documents.reserve(vcards.size());
+    Q_FOREACH(const QString &vcard, vcards) {
+        parse(vcard, &documents);
+    }
+    return documents;
+}
+
+QList<QVersitDocument> VCardTokenizer::parse(const QString &vcards)
+{
+    QList<QVersitDocument> documents;
+    parse(vcards, &documents);
+    return documents;
+}
+
+void VCardTokenizer::parse(const QString &vcards, QList<QVersitDocument> *documents)
+{
+    QVersitDocument document;
+    bool inDocument = false;
+    // nested documents (AGENT) are not supported by the service and are skipped
+    int nested = 0;
+    int pos = 0;
+
+    while (pos < vcards.size()) {
+        QStringRef line = takeLine(vcards, &pos);
+
+        // only folded lines are copied
+        QString unfolded;
+        while (isFolded(vcards, pos)) {
+            if (unfolded.isNull()) {
+                unfolded = line.toString();
+            }
+            pos++;
+            unfolded += takeLine(vcards, &pos);
+        }
+        if (!unfolded.isNull()) {
+            line = QStringRef(&unfolded);
+        }
+
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QVersitProperty property;
+        if (!parseLine(line, &property)) {
+            continue;
+        }
+
+        const QString name = property.name();
+        if (name == QStringLiteral("BEGIN")) {
+            if (inDocument) {
+                nested++;
+            } else {
+                document = QVersitDocument(QVersitDocument::VCard30Type);
+                document.setComponentType(property.value().toUpper());
+                inDocument = true;
+            }
+        } else if (name == QStringLiteral("END")) {
+            if (nested > 0) {
+                nested--;
+            } else if (inDocument) {
+                // drop documents with a malformed end line
+                if (property.value().compare(document.componentType(), Qt::CaseInsensitive) == 0) {
+                    documents->append(document);
+                }
+                inDocument = false;
+            }
+        } else if (!inDocument || (nested > 0)) {
+            continue;
+        } else if (name == QStringLiteral("VERSION")) {
+            if (property.value() == QStringLiteral("2.1")) {
+                document.setType(QVersitDocument::VCard21Type);
+            }
+        } else {
+            document.addProperty(property);
+        }
+    }
+}
+
+// [group.]name[;param[=value[,value]]]*:value
+bool VCardTokenizer::parseLine(const QStringRef &line, QVersitProperty *property)
+{
+    int colon = indexOf(line, QLatin1Char(':'), 0);
+    if (colon < 0) {
+        return false;
+    }
+
+    QStringRef head = line.left(colon);
+    QStringRef value = line.mid(colon + 1);
+
+    int semicolon = indexOf(head, QLatin1Char(';'), 0);
+    QStringList groups = ((semicolon < 0) ? head : head.left(semicolon)).toString().split(QLatin1Char('.'));
+    QString name = groups.takeLast().trimmed().toUpper();
+    if (name.isEmpty()) {
+        return false;
+    }
+    property->setGroups(groups);
+    property->setName(name);
+
+    while (semicolon >= 0) {
+        int next = indexOf(head, QLatin1Char(';'), semicolon + 1);
+        if (next < 0) {
+            parseParameter(head.mid(semicolon + 1), property);
+        } else {
+            parseParameter(head.mid(semicolon + 1, next - semicolon - 1), property);
+        }
+        semicolon = next;
+    }
+
+    QString encoding = property->parameters().value(QStringLiteral("ENCODING")).toUpper();
+    if ((encoding == QStringLiteral("B")) || (encoding == QStringLiteral("BASE64"))) {
+        property->removeParameters(QStringLiteral("ENCODING"));
+        property->setValue(QByteArray::fromBase64(value.toLatin1()));
+        property->setValueType(QVersitProperty::BinaryType);
+        return true;
+    }
+
+    QVersitProperty::ValueType type = valueType(name);
+    switch (type) {
+    case QVersitProperty::CompoundType:
+        property->setValue(split(value, QLatin1Char(';')));
+        break;
+    case QVersitProperty::ListType:
+        property->setValue(split(value, QLatin1Char(',')));
+        break;
+    default:
+        property->setValue(unescape(value));
+        break;
+    }
+    property->setValueType(type);
+    return true;
+}
+
+void VCardTokenizer::parseParameter(const QStringRef &parameter, QVersitProperty *property)
+{
+    // parameters are short, work on a copy
+    const QString text = parameter.toString().trimmed();
+    if (text.isEmpty()) {
+        return;
+    }
+
+    int equals = indexOf(QStringRef(&text), QLatin1Char('='), 0);
+    if (equals < 0) {
+        // vCard 2.1 parameters without name are types
+        property->insertParameter(QStringLiteral("TYPE"), text);
+        return;
+    }
+
+    QString name = text.left(equals).trimmed().toUpper();
+    int start = equals + 1;
+    while (start <= text.size()) {
+        int next = indexOf(QStringRef(&text), QLatin1Char(','), start);
+        if (next < 0) {
+            next = text.size();
+        }
+
+        QString value = text.mid(start, next - start).trimmed();
+        if ((value.size() >= 2) &&
+            value.startsWith(QLatin1Char('"')) && value.endsWith(QLatin1Char('"'))) {
+            value = value.mid(1, value.size() - 2);
+        } else {
+            // vCard 3.0 parameter values are escaped as the property values
+            value = unescape(QStringRef(&value));
+        }
+        property->insertParameter(name, value);
+        start = next + 1;
+    }
+}
+
+// find the separator outside of quoted parameter values and not escaped by '\'
+int VCardTokenizer::indexOf(const QStringRef &line, QChar separator, int from)
+{
+    bool quoted = false;
+    for (int i = from; i < line.size(); i++) {
+        const QChar c = line.at(i);
+        if (!quoted && (c == QLatin1Char('\\'))) {
+            i++;
+        } else if (c == QLatin1Char('"')) {
+            quoted = !quoted;
+        } else if (!quoted && (c == separator)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// split the value on the separators not escaped by '\'
+QStringList VCardTokenizer::split(const QStringRef &value, QChar separator)
+{
+    QStringList result;
+    int start = 0;
+    for (int i = 0; i < value.size(); i++) {
+        const QChar c = value.at(i);
+        if (c == QLatin1Char('\\')) {
+            i++;
+        } else if (c == separator) {
+            result << unescape(value.mid(start, i - start));
+            start = i + 1;
+        }
+    }
+    result << unescape(value.mid(start));
+    return result;
+}
+
+// RFC 2426 text value escaping
+QString VCardTokenizer::unescape(const QStringRef &value)
+{
+    if (value.indexOf(QLatin1Char('\\')) < 0) {
+        return value.toString();
+    }
+
+    QString result;
+    result.reserve(value.size());
+    for (int i = 0; i < value.size(); i++) {
+        QChar c = value.at(i);
+        if ((c == QLatin1Char('\\')) && ((i + 1) < value.size())) {
+            c = value.at(++i);
+            if ((c == QLatin1Char('n')) || (c == QLatin1Char('N'))) {
+                c = QLatin1Char('\n');
+            }
+        }
+        result += c;
+    }
+    return result;
+}
+
+QVersitProperty::ValueType VCardTokenizer::valueType(const QString &name)
+{
+    static const QHash<QString, QVersitProperty::ValueType> types = valueTypes();
+    return types.value(name, QVersitProperty::PlainType);
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_VCARD_TOKENIZER_H__
+#define __GALERA_VCARD_TOKENIZER_H__
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QStringRef>
+
+#include <QtVersit/QVersitDocument>
+#include <QtVersit/QVersitProperty>
+
+namespace galera
+{
+
+// Tokenize the vCards written by the service (see VCardWriter) straight from the
+// strings received over D-Bus. Lines are unfolded and split in place, this avoid
+// joining the vCards, the UTF-8 round trip and the QVersitReader thread.
+class VCardTokenizer
+{
+public:
+    static QList<QtVersit::QVersitDocument> parse(const QStringList &vcards);
+    static QList<QtVersit::QVersitDocument> parse(const QString &vcards);
+
+private:
+    static void parse(const QString &vcards, QList<QtVersit::QVersitDocument> *documents);
+    static bool parseLine(const QStringRef &line, QtVersit::QVersitProperty *property);
+    static void parseParameter(const QStringRef &parameter, QtVersit::QVersitProperty *property);
+    static int indexOf(const QStringRef &line, QChar separator, int from);
+    static QStringList split(const QStringRef &value, QChar separator);
+    static QString unescape(const QStringRef &value);
+    static QtVersit::QVersitProperty::ValueType valueType(const QString &name);
+};
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vcard-writer.h"
+
+#include <QtCore/QRegExp>
+#include <QtCore/QVariant>
+
+using namespace QtVersit;
+
+namespace
+{
+    // same line width of QVersitWriter, lines are folded after it
+    const int MaxLineLength = 76;
+    const int InitialBufferSize = 1024;
+}
+
+namespace galera
+{
+
+VCardWriter::VCardWriter()
+    : m_lineLength(0)
+{
+    // reserved capacity is kept when the buffer is resized to 0
+    m_buffer.reserve(InitialBufferSize);
+}
+
+QString VCardWriter::write(const QVersitDocument &document)
+{
+    m_buffer.resize(0);
+    m_lineLength = 0;
+
+    writeDocument(document);
+
+    return QString::fromUtf8(m_buffer);
+}
+
+QStringList VCardWriter::write(const QList<QVersitDocument> &documents)
+{
+    QStringList result;
+    result.reserve(documents.size());
+    Q_FOREACH(const QVersitDocument &document, documents) {
+        result << write(document);
+    }
+    return result;
+}
+
+void VCardWriter::writeDocument(const QVersitDocument &document)
+{
+    QString componentType = document.componentType();
+    if (componentType.isEmpty()) {
+        componentType = QStringLiteral("VCARD");
+    }
+
+    writeLine(QStringLiteral("BEGIN:") + componentType);
+    writeLine(QStringLiteral("VERSION:3.0"));
+    Q_FOREACH(const QVersitProperty &property, document.properties()) {
+        writeProperty(property);
+    }
+    Q_FOREACH(const QVersitDocument &subDocument, document.subDocuments()) {
+        writeDocument(subDocument);
+    }
+    writeLine(QStringLiteral("END:") + componentType);
+}
+
+// same output of QVCard30Writer::encodeVersitProperty()
+void VCardWriter::writeProperty(const QVersitProperty &property)
+{
+    QVersitProperty modifiedProperty(property);
+    if (property.name() == QStringLiteral("X-NICKNAME")) {
+        modifiedProperty.setName(QStringLiteral("NICKNAME"));
+    } else if (property.name() == QStringLiteral("X-IMPP")) {
+        modifiedProperty.setName(QStringLiteral("IMPP"));
+    }
+
+    const QVariant variant = modifiedProperty.variantValue();
+    if (variant.type() == QVariant::ByteArray) {
+        modifiedProperty.insertParameter(QStringLiteral("ENCODING"), QStringLiteral("b"));
+    }
+
+    if (!modifiedProperty.groups().isEmpty()) {
+        writeString(modifiedProperty.groups().join(QStringLiteral(".")));
+        writeString(QStringLiteral("."));
+    }
+    writeString(modifiedProperty.name());
+    writeParameters(modifiedProperty.parameters());
+    writeString(QStringLiteral(":"));
+
+    QString value;
+    if (variant.userType() == qMetaTypeId<QVersitDocument>()) {
+        // nested documents (AGENT) are written as text
+        VCardWriter nested;
+        value = escape(nested.write(variant.value<QVersitDocument>()));
+    } else if (variant.type() == QVariant::String) {
+        value = variant.toString();
+        if (property.valueType() != QVersitProperty::PreformattedType) {
+            value = escape(value);
+        }
+    } else if (variant.type() == QVariant::StringList) {
+        // compound values are separated by ';' and lists by ',', empty list items are skipped
+        const bool isCompound = (property.valueType() == QVersitProperty::CompoundType);
+        QStringList values;
+        Q_FOREACH(const QString &item, variant.toStringList()) {
+            if (isCompound || !item.isEmpty()) {
+                values << escape(item);
+            }
+        }
+        value = values.join(isCompound ? QStringLiteral(";") : QStringLiteral(","));
+    } else if (variant.type() == QVariant::ByteArray) {
+        value = QString::fromLatin1(variant.toByteArray().toBase64());
+    }
+    // QVersitWriter does not write values of other types
+
+    writeString(value);
+    endLine();
+}
+
+// the parameters are written in the hash order with the values in the QMultiHash order,
+// as QVersitWriter does
+void VCardWriter::writeParameters(const QMultiHash<QString, QString> &parameters)
+{
+    Q_FOREACH(const QString &name, parameters.uniqueKeys()) {
+        writeString(QStringLiteral(";"));
+        writeString(escape(name));
+        writeString(QStringLiteral("="));
+        QStringList values = parameters.values(name);
+        for (int i = 0; i < values.size(); i++) {
+            if (i > 0) {
+                writeString(QStringLiteral(","));
+            }
+            writeString(escape(values.at(i)));
+        }
+    }
+}
+
+void VCardWriter::writeString(const QString &value)
+{
+    // 'start' counts the chars as QVersitWriter does, 'written' is the first char not
+    // written yet. A high surrogate at the end of a folded line is written on the next
+    // line together with its pair, as the QVersitWriter encoder does
+    int start = 0;
+    int written = 0;
+    while ((value.size() - start) > (MaxLineLength - m_lineLength)) {
+        start += MaxLineLength - m_lineLength;
+        int end = start;
+        if ((end > written) && value.at(end - 1).isHighSurrogate()) {
+            end--;
+        }
+        m_buffer += value.midRef(written, end - written).toUtf8();
+        written = end;
+        // folded lines start with a white space
+        m_buffer += "\r\n ";
+        m_lineLength = 1;
+    }
+
+    m_buffer += value.midRef(written).toUtf8();
+    m_lineLength += value.size() - start;
+}
+
+void VCardWriter::writeLine(const QString &value)
+{
+    writeString(value);
+    endLine();
+}
+
+void VCardWriter::endLine()
+{
+    m_buffer += "\r\n";
+    m_lineLength = 0;
+}
+
+// same escaping of QVCard30Writer::backSlashEscape()
+QString VCardWriter::escape(const QString &value)
+{
+    if (!value.contains(QLatin1Char('\\')) &&
+        !value.contains(QLatin1Char(',')) &&
+        !value.contains(QLatin1Char(';')) &&
+        !value.contains(QLatin1Char('\n')) &&
+        !value.contains(QLatin1Char('\r'))) {
+        return value;
+    }
+
+    static const QRegExp separators(QStringLiteral("([\\\\,;])"));
+    static const QRegExp lineBreaks(QStringLiteral("\r\n|\r|\n"));
+    QString result(value);
+    result.replace(separators, QStringLiteral("\\\\1"));
+    result.replace(lineBreaks, QStringLiteral("\\n"));
+    return result;
+}
+
+}
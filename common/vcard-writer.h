@@ -0,0 +1,63 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_VCARD_WRITER_H__
+#define __GALERA_VCARD_WRITER_H__
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMultiHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <QtVersit/QVersitDocument>
+#include <QtVersit/QVersitProperty>
+
+namespace galera
+{
+
+// Write vCard 3.0 documents in a single pass with the same output of QVersitWriter
+// (parameter order, escaping and line folding). Each document is written directly into a
+// buffer reused by all documents, this avoid the QVersitWriter thread and the split of
+// the joined output.
+class VCardWriter
+{
+public:
+    VCardWriter();
+
+    QString write(const QtVersit::QVersitDocument &document);
+    QStringList write(const QList<QtVersit::QVersitDocument> &documents);
+
+private:
+    QByteArray m_buffer;
+    // number of chars on the current line, used to fold long lines
+    int m_lineLength;
+
+    void writeDocument(const QtVersit::QVersitDocument &document);
+    void writeProperty(const QtVersit::QVersitProperty &property);
+    void writeParameters(const QMultiHash<QString, QString> &parameters);
+    void writeString(const QString &value);
+    void writeLine(const QString &value);
+    void endLine();
+
+    static QString escape(const QString &value);
+};
+
+}
+
+#endif
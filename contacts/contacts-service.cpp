@@ -53,6 +53,8 @@
 
 #define ALTERNATIVE_CPIM_SERVICE_PAGE_SIZE  "CANONICAL_PIM_SERVICE_PAGE_SIZE"
 #define FETCH_PAGE_SIZE                     25
+#define FETCH_MAX_PAGE_SIZE                 800
+#define FETCH_PAGES_IN_FLIGHT               2
 
 using namespace QtVersit;
 using namespace QtContacts;
@@ -241,28 +243,130 @@ void GaleraContactsService::fetchContactsById(QtContacts::QContactFetchByIdReque
         return;
     }
 
-    QContactIdFilter filter;
-    filter.setIds(request->contactIds());
-    QString filterStr = Filter(filter).toString();
-    QDBusMessage result = m_iface->call("query",
-                                        filterStr, "",
-                                        request->fetchHint().maxCountHint(),
-                                        m_showInvisibleContacts,
-                                        QStringList());
-    if (result.type() == QDBusMessage::ErrorMessage) {
-        qWarning() << result.errorName() << result.errorMessage();
-        QContactFetchByIdRequestData::notifyError(request);
+    QContactFetchByIdRequestData *data = new QContactFetchByIdRequestData(request, 0);
+    m_runningRequests << data;
+
+    // requests done in the same event loop iteration are sent to the server in a single query
+    m_pendingFetchByIdRequests << request;
+    if (m_pendingFetchByIdRequests.size() == 1) {
+        QMetaObject::invokeMethod(this, "fetchPendingContactsById", Qt::QueuedConnection);
+    }
+}
+
+void GaleraContactsService::fetchPendingContactsById()
+{
+    QList<QPointer<QContactFetchByIdRequest> > pending = m_pendingFetchByIdRequests;
+    m_pendingFetchByIdRequests.clear();
+
+    if (!isOnline()) {
+        qWarning() << "Server is not online";
+        // reply the requests with the same error used for a failed query
+        fetchContactsByIdDone(pending, 0);
         return;
     }
 
-    QDBusObjectPath viewObjectPath = result.arguments()[0].value<QDBusObjectPath>();
-    QDBusInterface *view = new QDBusInterface(m_serviceName,
-                                             viewObjectPath.path(),
-                                             CPIM_ADDRESSBOOK_VIEW_IFACE_NAME);
+    // requests with different fields can not share the same vCards
+    QMap<QString, QList<QPointer<QContactFetchByIdRequest> > > batches;
+    Q_FOREACH(const QPointer<QContactFetchByIdRequest> &request, pending) {
+        QContactFetchRequestData *data = static_cast<QContactFetchRequestData*>(requestData(request.data()));
+        if (data && data->isLive()) {
+            batches[data->fields().join(",")] << request;
+        }
+    }
 
-    QContactFetchByIdRequestData *data = new QContactFetchByIdRequestData(request, view);
-    m_runningRequests << data;
-    fetchContactsPage(data);
+    Q_FOREACH(const QList<QPointer<QContactFetchByIdRequest> > &batch, batches) {
+        QList<QContactId> ids;
+        QSet<QContactId> uniqueIds;
+        Q_FOREACH(const QPointer<QContactFetchByIdRequest> &request, batch) {
+            Q_FOREACH(const QContactId &id, request->contactIds()) {
+                if (!uniqueIds.contains(id)) {
+                    uniqueIds << id;
+                    ids << id;
+                }
+            }
+        }
+
+        QContactIdFilter filter;
+        filter.setIds(ids);
+        QStringList fields = static_cast<QContactFetchRequestData*>(requestData(batch.first().data()))->fields();
+
+        // the result can not be bigger than the number of ids, it is returned in a single page
+        QDBusPendingCall pcall = m_iface->asyncCall("queryPage",
+                                                    Filter(filter).toString(),
+                                                    QString(),
+                                                    fields,
+                                                    ids.size(),
+                                                    m_showInvisibleContacts,
+                                                    QStringList());
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         [=](QDBusPendingCallWatcher *call) {
+                            this->fetchContactsByIdDone(batch, call);
+                         });
+    }
+}
+
+void GaleraContactsService::fetchContactsByIdDone(const QList<QPointer<QContactFetchByIdRequest> > &batch,
+                                                  QDBusPendingCallWatcher *call)
+{
+    QList<QContact> contacts;
+    bool failed = (call == 0);
+    if (call) {
+        call->deleteLater();
+
+        QDBusPendingReply<QStringList> reply = *call;
+        if (reply.isError()) {
+            qWarning() << reply.error().name() << reply.error().message();
+            failed = true;
+        } else {
+            contacts = VCardParser::vcardToContactSync(reply.value());
+        }
+    }
+
+    if (!failed) {
+        QList<QContact>::iterator contact;
+        for (contact = contacts.begin(); contact != contacts.end(); ++contact) {
+            if (!contact->isEmpty()) {
+                QContactGuid detailId = contact->detail<QContactGuid>();
+                QContactId newId(m_managerUri, detailId.guid().toUtf8());
+                contact->setId(newId);
+            }
+        }
+    }
+
+    // send to every request the contacts that it asked for
+    Q_FOREACH(const QPointer<QContactFetchByIdRequest> &request, batch) {
+        QContactRequestData *data = requestData(request.data());
+        if (!data) {
+            continue;
+        }
+
+        if (!data->isLive()) {
+            destroyRequest(data);
+            continue;
+        }
+
+        if (failed) {
+            data->finish(QContactManager::UnspecifiedError);
+            destroyRequest(data);
+            continue;
+        }
+
+        QSet<QContactId> ids = request->contactIds().toSet();
+        int maxCount = request->fetchHint().maxCountHint();
+        QList<QContact> result;
+        Q_FOREACH(const QContact &contact, contacts) {
+            if ((maxCount > 0) && (result.size() >= maxCount)) {
+                break;
+            }
+            if (ids.contains(contact.id())) {
+                result << contact;
+            }
+        }
+
+        static_cast<QContactFetchRequestData*>(data)->update(result, QContactAbstractRequest::FinishedState);
+        destroyRequest(data);
+    }
 }
 
 void GaleraContactsService::fetchContacts(QtContacts::QContactFetchRequest *request)
@@ -304,6 +408,16 @@ void GaleraContactsService::fetchContacts(QtContacts::QContactFetchRequest *requ
     QString sortStr = SortClause(request->sorting()).toString();
     QString filterStr = Filter(request->filter()).toString();
     FetchHint fetchHint = FetchHint(request->fetchHint()).toString();
+
+    // the result fits in one page, fetch it without create a view
+    int maxCount = request->fetchHint().maxCountHint();
+    if ((maxCount > 0) && (maxCount <= m_pageSize)) {
+        QContactFetchRequestData *data = new QContactFetchRequestData(request, 0, fetchHint);
+        m_runningRequests << data;
+        fetchContactsOneShot(data, filterStr, sortStr, maxCount);
+        return;
+    }
+
     QDBusPendingCall pcall = m_iface->asyncCall("query",
                                                 filterStr,
                                                 sortStr,
@@ -347,22 +461,23 @@ void GaleraContactsService::fetchContactsContinue(QContactFetchRequestData *data
                                                   viewObjectPath.path(),
                                                   CPIM_ADDRESSBOOK_VIEW_IFACE_NAME);
         data->updateView(view);
+        data->updatePageSize(m_pageSize);
         fetchContactsPage(data);
     }
 }
 
-void GaleraContactsService::fetchContactsPage(QContactFetchRequestData *data)
+void GaleraContactsService::fetchContactsOneShot(QContactFetchRequestData *data,
+                                                 const QString &filter,
+                                                 const QString &sort,
+                                                 int maxCount)
 {
-    if (!isOnline() || !data->isLive()) {
-        destroyRequest(data);
-        return;
-    }
-
-    // Load contacs async
-    QDBusPendingCall pcall = data->view()->asyncCall("contactsDetails",
-                                                     data->fields(),
-                                                     data->offset(),
-                                                     m_pageSize);
+    QDBusPendingCall pcall = m_iface->asyncCall("queryPage",
+                                                filter,
+                                                sort,
+                                                data->fields(),
+                                                maxCount,
+                                                m_showInvisibleContacts,
+                                                QStringList());
     if (pcall.isError()) {
         qWarning() << pcall.error().name() << pcall.error().message();
         data->finish(QContactManager::UnspecifiedError);
@@ -371,21 +486,57 @@ void GaleraContactsService::fetchContactsPage(QContactFetchRequestData *data)
     }
 
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, 0);
-    data->updateWatcher(watcher);
+    data->appendLastPage(watcher);
     QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
-                     [=](QDBusPendingCallWatcher *call) {
-                        this->fetchContactsDone(data, call);
+                     [=](QDBusPendingCallWatcher *) {
+                        this->fetchContactsDone(data);
                      });
 }
 
-void GaleraContactsService::fetchContactsDone(QContactFetchRequestData *data,
-                                              QDBusPendingCallWatcher *call)
+void GaleraContactsService::fetchContactsPage(QContactFetchRequestData *data)
+{
+    if (!isOnline() || !data->isLive()) {
+        destroyRequest(data);
+        return;
+    }
+
+    // Load contacs async, the next pages are requested while the current one is parsed
+    while (!data->isLastPageRequested() &&
+           (data->pagesInFlight() < FETCH_PAGES_IN_FLIGHT)) {
+        QDBusPendingCall pcall = data->view()->asyncCall("contactsDetails",
+                                                         data->fields(),
+                                                         data->offset(),
+                                                         data->pageSize());
+        if (pcall.isError()) {
+            qWarning() << pcall.error().name() << pcall.error().message();
+            data->finish(QContactManager::UnspecifiedError);
+            destroyRequest(data);
+            return;
+        }
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, 0);
+        data->appendPage(watcher, FETCH_MAX_PAGE_SIZE);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         [=](QDBusPendingCallWatcher *) {
+                            this->fetchContactsDone(data);
+                         });
+    }
+}
+
+void GaleraContactsService::fetchContactsDone(QContactFetchRequestData *data)
 {
     if (!data->isLive()) {
         destroyRequest(data);
         return;
     }
 
+    // pages are parsed one at time in the request order
+    if (data->isParsing() || !data->isPageReady()) {
+        return;
+    }
+
+    int pageSize = 0;
+    QSharedPointer<QDBusPendingCallWatcher> call = data->takePage(&pageSize);
     QDBusPendingReply<QStringList> reply = *call;
     if (reply.isError()) {
         qWarning() << reply.error().name() << reply.error().message();
@@ -393,24 +544,35 @@ void GaleraContactsService::fetchContactsDone(QContactFetchRequestData *data,
                         QContactAbstractRequest::FinishedState,
                         QContactManager::UnspecifiedError);
         destroyRequest(data);
-    } else {
-        const QStringList vcards = reply.value();
-        if (vcards.size()) {
-            VCardParser *parser = new VCardParser;
-            parser->setProperty("DATA", QVariant::fromValue<void*>(data));
-            data->setVCardParser(parser);
-            connect(parser,
-                    SIGNAL(contactsParsed(QList<QtContacts::QContact>)),
-                    SLOT(onVCardsParsed(QList<QtContacts::QContact>)));
-            connect(parser,
-                    SIGNAL(canceled()),
-                    SLOT(onVCardParseCanceled()));
-            parser->vcardToContact(vcards);
-        } else {
-            data->update(QList<QContact>(), QContactAbstractRequest::FinishedState);
-            destroyRequest(data);
-        }
+        return;
+    }
+
+    const QStringList vcards = reply.value();
+    bool lastPage = ((pageSize < 0) || (vcards.size() < pageSize));
+    if (lastPage) {
+        data->setLastPageRequested();
+    }
+
+    if (vcards.isEmpty()) {
+        data->update(QList<QContact>(), QContactAbstractRequest::FinishedState);
+        destroyRequest(data);
+        return;
     }
+
+    VCardParser *parser = new VCardParser;
+    parser->setProperty("DATA", QVariant::fromValue<void*>(data));
+    parser->setProperty("LAST_PAGE", lastPage);
+    data->setVCardParser(parser);
+    connect(parser,
+            SIGNAL(contactsParsed(QList<QtContacts::QContact>)),
+            SLOT(onVCardsParsed(QList<QtContacts::QContact>)));
+    connect(parser,
+            SIGNAL(canceled()),
+            SLOT(onVCardParseCanceled()));
+    parser->vcardToContact(vcards);
+
+    // keep the pipeline full
+    fetchContactsPage(data);
 }
 
 void GaleraContactsService::onVCardParseCanceled()
@@ -453,17 +615,16 @@ void GaleraContactsService::onVCardsParsed(QList<QContact> contacts)
         }
     }
 
-    if (contacts.size() == m_pageSize) {
+    sender->deleteLater();
+
+    if (!sender->property("LAST_PAGE").toBool()) {
         data->update(contacts, QContactAbstractRequest::ActiveState);
-        data->updateOffset(m_pageSize);
-        data->updateWatcher(0);
-        fetchContactsPage(data);
+        // parse the next page if it already arrived
+        fetchContactsDone(data);
     } else {
         data->update(contacts, QContactAbstractRequest::FinishedState);
         destroyRequest(data);
     }
-
-    sender->deleteLater();
 }
 
 void GaleraContactsService::fetchContactsGroupsContinue(QContactFetchRequestData *data,
@@ -577,7 +738,7 @@ void GaleraContactsService::createGroupDone(QContactSaveRequestData *data,
     QDBusPendingReply<Source> reply = *call;
     if (reply.isError()) {
         qWarning() << reply.error().name() << reply.error().message();
-        data->notifyUpdateError(QContactManager::UnspecifiedError);
+        data->notifyCurrentGroupError(QContactManager::UnspecifiedError);
     } else {
         data->updateCurrentGroup(reply.value(), m_managerUri);
     }
@@ -589,8 +750,7 @@ void GaleraContactsService::createGroupDone(QContactSaveRequestData *data,
 /* After handle all contacts with type = 'QContactType::TypeGroup', we need to
  * create the real contacts.
  *
- * Due the Server limitation we will call this function for each contact
- * sequentially.
+ * All contacts with the same sync target are created in a single call.
  */
 void GaleraContactsService::createContactsStart(QContactSaveRequestData *data)
 {
@@ -608,9 +768,9 @@ void GaleraContactsService::createContactsStart(QContactSaveRequestData *data)
     }
 
     QString syncSource;
-    QString contact = data->nextContact(&syncSource);
+    QStringList contacts = data->nextContacts(&syncSource);
 
-    QDBusPendingCall pcall = m_iface->asyncCall("createContact", contact, syncSource);
+    QDBusPendingCall pcall = m_iface->asyncCall("createContacts", contacts, syncSource);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, 0);
     data->updateWatcher(watcher);
     QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
@@ -619,9 +779,9 @@ void GaleraContactsService::createContactsStart(QContactSaveRequestData *data)
                      });
 }
 
-/* 'createContact' will call this function when done,
- * we need to check for errors and update the contact Id with the new Id, and
- * call 'createContactsStart' to continue with the next contact.
+/* 'createContacts' will call this function when done, the reply contains the
+ * vCard of each new contact or an empty string for the contacts that failed.
+ * Call 'createContactsStart' to continue with the contacts of the next sync target.
   */
 void GaleraContactsService::createContactsDone(QContactSaveRequestData *data,
                                                QDBusPendingCallWatcher *call)
@@ -632,24 +792,26 @@ void GaleraContactsService::createContactsDone(QContactSaveRequestData *data,
         return;
     }
 
-    QDBusPendingReply<QString> reply = *call;
+    QDBusPendingReply<QStringList> reply = *call;
     if (reply.isError()) {
         qWarning() << reply.error().name() << reply.error().message();
-        data->notifyUpdateError(QContactManager::UnspecifiedError);
+        data->notifyCurrentContactsError(QContactManager::UnspecifiedError);
     } else {
-        const QString vcard = reply.value();
-        if (!vcard.isEmpty()) {
-            QContact contact = VCardParser::vcardToContact(vcard);
-            QContactGuid detailId = contact.detail<QContactGuid>();
-            QContactId newId(m_managerUri, detailId.guid().toUtf8());
-            contact.setId(newId);
-            data->updateCurrentContact(contact);
-        } else {
-            data->notifyUpdateError(QContactManager::UnspecifiedError);
+        QList<QContact> contacts;
+        Q_FOREACH(const QString &vcard, reply.value()) {
+            QContact contact;
+            if (!vcard.isEmpty()) {
+                contact = VCardParser::vcardToContact(vcard);
+                QContactGuid detailId = contact.detail<QContactGuid>();
+                QContactId newId(m_managerUri, detailId.guid().toUtf8());
+                contact.setId(newId);
+            }
+            contacts << contact;
         }
+        data->updateCurrentContacts(contacts);
     }
 
-    // go to next contact
+    // go to next sync target
     createContactsStart(data);
 }
 
@@ -960,6 +1122,20 @@ void GaleraContactsService::addRequest(QtContacts::QContactAbstractRequest *requ
     }
 }
 
+QContactRequestData *GaleraContactsService::requestData(QContactAbstractRequest *request) const
+{
+    if (!request) {
+        return 0;
+    }
+
+    Q_FOREACH(QContactRequestData *rData, m_runningRequests) {
+        if (rData->request() == request) {
+            return rData;
+        }
+    }
+    return 0;
+}
+
 void GaleraContactsService::destroyRequest(QContactRequestData *request)
 {
     // only destroy the resquest data if it still on the list
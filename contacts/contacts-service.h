@@ -24,6 +24,7 @@
 #include <QtCore/QStringList>
 #include <QtCore/QSet>
 #include <QtCore/QMutex>
+#include <QtCore/QPointer>
 #include <QtCore/QQueue>
 #include <QtCore/QSharedPointer>
 
@@ -32,6 +33,7 @@
 #include <QtContacts/QContact>
 #include <QtContacts/QContactManagerEngine>
 #include <QtContacts/QContactChangeSet>
+#include <QtContacts/QContactFetchByIdRequest>
 
 #include <QtVersit/QVersitContactImporter>
 
@@ -84,6 +86,8 @@ private Q_SLOTS:
     void onServiceReady();
     void onVCardsParsed(QList<QtContacts::QContact> contacts);
     void onVCardParseCanceled();
+    void fetchPendingContactsById();
+
 private:
     QString m_managerUri;                                       // for faster lookup.
     QDBusServiceWatcher *m_serviceWatcher;
@@ -94,6 +98,8 @@ private:
     QSharedPointer<QDBusInterface> m_iface;
     QString m_serviceName;
     QList<QContactRequestData*> m_runningRequests;
+    // fetch by id requests waiting to be sent in a single query
+    QList<QPointer<QtContacts::QContactFetchByIdRequest> > m_pendingFetchByIdRequests;
 
     Q_INVOKABLE void initialize();
     Q_INVOKABLE void deinitialize();
@@ -109,8 +115,11 @@ private:
     void fetchContactsGroupsContinue(QContactFetchRequestData *request,
                                      QDBusPendingCallWatcher *call);
     void fetchContactsById(QtContacts::QContactFetchByIdRequest *request);
+    void fetchContactsByIdDone(const QList<QPointer<QtContacts::QContactFetchByIdRequest> > &batch,
+                               QDBusPendingCallWatcher *call);
+    void fetchContactsOneShot(QContactFetchRequestData *data, const QString &filter, const QString &sort, int maxCount);
     void fetchContactsPage(QContactFetchRequestData *data);
-    void fetchContactsDone(QContactFetchRequestData *data, QDBusPendingCallWatcher *call);
+    void fetchContactsDone(QContactFetchRequestData *data);
 
     void saveContact(QtContacts::QContactSaveRequest *request);
     void createGroupsStart(QContactSaveRequestData *data);
@@ -126,6 +135,7 @@ private:
     void removeContactContinue(QContactRemoveRequestData *data, QDBusPendingCallWatcher *call);
     void removeContactDone(QContactRemoveRequestData *data, QDBusPendingCallWatcher *call);
 
+    QContactRequestData *requestData(QtContacts::QContactAbstractRequest *request) const;
     void destroyRequest(QContactRequestData *request);
 
     QList<QContactId> parseIds(const QStringList &ids) const;
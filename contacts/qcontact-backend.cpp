@@ -58,6 +58,7 @@ GaleraManagerEngine* GaleraManagerEngine::createEngine(const QMap<QString, QStri
 {
     GaleraManagerEngine *engine = new GaleraManagerEngine();
     engine->m_service->setShowInvisibleContacts(parameters.value(ADDRESS_BOOK_SHOW_INVISIBLE_PROP, "false").toLower() == "true");
+    engine->m_cache.setMaxSize(parameters.value(ADDRESS_BOOK_CACHE_SIZE_PROP, "0").toInt());
     return engine;
 }
 
@@ -68,6 +69,11 @@ GaleraManagerEngine* GaleraManagerEngine::createEngine(const QMap<QString, QStri
 GaleraManagerEngine::GaleraManagerEngine()
     : m_service(new GaleraContactsService(managerUri()))
 {
+    // invalidate the cache before notify the changes to the application
+    connect(m_service, &GaleraContactsService::contactsRemoved, this, &GaleraManagerEngine::invalidateContacts);
+    connect(m_service, &GaleraContactsService::contactsUpdated, this, &GaleraManagerEngine::invalidateContacts);
+    connect(m_service, &GaleraContactsService::serviceChanged, this, &GaleraManagerEngine::clearCache);
+
     connect(m_service, &GaleraContactsService::contactsAdded, this, &QContactManagerEngine::contactsAdded);
     connect(m_service, &GaleraContactsService::contactsRemoved, this, &QContactManagerEngine::contactsRemoved);
     connect(m_service, &GaleraContactsService::contactsUpdated, this, &QContactManagerEngine::contactsChanged);
@@ -137,26 +143,83 @@ QList<QContact> GaleraManagerEngine::contacts(const QList<QContactId> &contactId
                                               QMap<int, QContactManager::Error> *errorMap,
                                               QContactManager::Error *error) const
 {
-    QContactFetchByIdRequest request;
-    request.setIds(contactIds);
-    request.setFetchHint(fetchHint);
-
-    const_cast<GaleraManagerEngine*>(this)->startRequest(&request);
-    const_cast<GaleraManagerEngine*>(this)->waitForRequestFinished(&request, -1);
+    // contacts found on cache and the index of the ones that need to be fetched
+    QHash<QContactId, QContact> cached;
+    QList<QContactId> missingIds;
+    QList<int> missingIndexes;
+    for (int i = 0; i < contactIds.size(); i++) {
+        QContact contact;
+        if (m_cache.find(contactIds.at(i), fetchHint, &contact)) {
+            cached.insert(contactIds.at(i), contact);
+        } else {
+            missingIds << contactIds.at(i);
+            missingIndexes << i;
+        }
+    }
 
+    if (error) {
+        *error = QContactManager::NoError;
+    }
     if (errorMap) {
-        *errorMap = request.errorMap();
+        errorMap->clear();
     }
 
-    if (error) {
-        *error = request.error();
+    if (!missingIds.isEmpty()) {
+        QContactFetchByIdRequest request;
+        request.setIds(missingIds);
+        request.setFetchHint(fetchHint);
+
+        const_cast<GaleraManagerEngine*>(this)->startRequest(&request);
+        const_cast<GaleraManagerEngine*>(this)->waitForRequestFinished(&request, -1);
+
+        if (errorMap) {
+            // map the errors to the index of the ids requested by the caller
+            QMap<int, QContactManager::Error> requestErrors = request.errorMap();
+            QMap<int, QContactManager::Error>::const_iterator i;
+            for (i = requestErrors.constBegin(); i != requestErrors.constEnd(); ++i) {
+                errorMap->insert(missingIndexes.value(i.key(), i.key()), i.value());
+            }
+        }
+
+        if (error) {
+            *error = request.error();
+        }
+
+        if (request.error() == QContactManager::NoError) {
+            Q_FOREACH(const QContact &contact, request.contacts()) {
+                m_cache.insert(contact, fetchHint);
+            }
+        }
+
+        // nothing was found on the cache, keep the order returned by the server
+        if (cached.isEmpty()) {
+            return request.contacts();
+        }
+
+        Q_FOREACH(const QContact &contact, request.contacts()) {
+            cached.insert(contact.id(), contact);
+        }
     }
 
-    return request.contacts();
+    QList<QContact> result;
+    Q_FOREACH(const QContactId &id, contactIds) {
+        if (cached.contains(id)) {
+            result << cached.value(id);
+        }
+    }
+    return result;
 }
 
 QContact GaleraManagerEngine::contact(const QContactId &contactId, const QContactFetchHint &fetchHint, QContactManager::Error *error) const
 {
+    QContact contact;
+    if (m_cache.find(contactId, fetchHint, &contact)) {
+        if (error) {
+            *error = QContactManager::NoError;
+        }
+        return contact;
+    }
+
     QContactFetchByIdRequest request;
     request.setIds(QList<QContactId>() << contactId);
     request.setFetchHint(fetchHint);
@@ -168,7 +231,11 @@ QContact GaleraManagerEngine::contact(const QContactId &contactId, const QContac
         *error = request.error();
     }
 
-    return request.contacts().value(0, QContact());
+    contact = request.contacts().value(0, QContact());
+    if ((request.error() == QContactManager::NoError) && !contact.isEmpty()) {
+        m_cache.insert(contact, fetchHint);
+    }
+    return contact;
 }
 
 bool GaleraManagerEngine::saveContact(QtContacts::QContact *contact, QtContacts::QContactManager::Error *error)
@@ -311,6 +378,16 @@ bool GaleraManagerEngine::validateContact(const QtContacts::QContact &contact, Q
     return true;
 }
 
+void GaleraManagerEngine::invalidateContacts(const QList<QContactId> &ids)
+{
+    m_cache.remove(ids);
+}
+
+void GaleraManagerEngine::clearCache()
+{
+    m_cache.clear();
+}
+
 /* Asynchronous Request Support */
 void GaleraManagerEngine::requestDestroyed(QtContacts::QContactAbstractRequest *req)
 {
@@ -323,6 +400,17 @@ bool GaleraManagerEngine::startRequest(QtContacts::QContactAbstractRequest *req)
         return false;
     }
 
+    // do not wait for the server notification to drop the contacts changed by this process
+    if (req->type() == QContactAbstractRequest::ContactSaveRequest) {
+        QList<QContactId> ids;
+        Q_FOREACH(const QContact &contact, static_cast<QContactSaveRequest*>(req)->contacts()) {
+            ids << contact.id();
+        }
+        m_cache.remove(ids);
+    } else if (req->type() == QContactAbstractRequest::ContactRemoveRequest) {
+        m_cache.remove(static_cast<QContactRemoveRequest*>(req)->contactIds());
+    }
+
     QPointer<QContactAbstractRequest> checkDeletion(req);
     updateRequestState(req, QContactAbstractRequest::ActiveState);
     if (!checkDeletion.isNull()) {
@@ -27,6 +27,8 @@
 
 #include <QtDBus/QDBusInterface>
 
+#include "qcontact-cache.h"
+
 namespace galera
 {
 class GaleraContactsService;
@@ -92,12 +94,18 @@ public:
     bool isFilterSupported(const QtContacts::QContactFilter &filter) const override;
     QList<QVariant::Type> supportedDataTypes() const override;
 
+private Q_SLOTS:
+    void invalidateContacts(const QList<QtContacts::QContactId> &ids);
+    void clearCache();
+
 private:
     GaleraManagerEngine();
 
     QList<QtContacts::QContactId> contactIds(const QList<QtContacts::QContact> &contacts) const;
 
     GaleraContactsService *m_service;
+    // opt-in cache used by the contact fetch by id functions
+    mutable GaleraContactCache m_cache;
 };
 
 } //namespace
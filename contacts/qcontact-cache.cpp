@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qcontact-cache.h"
+
+#include "common/fetch-hint.h"
+
+using namespace QtContacts;
+
+namespace galera
+{
+
+GaleraContactCache::GaleraContactCache()
+{
+    m_contacts.setMaxCost(0);
+}
+
+bool GaleraContactCache::isEnabled() const
+{
+    return (m_contacts.maxCost() > 0);
+}
+
+void GaleraContactCache::setMaxSize(int maxSize)
+{
+    m_contacts.setMaxCost(qMax(maxSize, 0));
+}
+
+bool GaleraContactCache::find(const QContactId &id,
+                              const QContactFetchHint &hint,
+                              QContact *contact) const
+{
+    QHash<QString, QContact> *contacts = m_contacts.object(id);
+    if (!contacts) {
+        return false;
+    }
+
+    QHash<QString, QContact>::const_iterator i = contacts->constFind(hintKey(hint));
+    if (i == contacts->constEnd()) {
+        return false;
+    }
+
+    *contact = i.value();
+    return true;
+}
+
+void GaleraContactCache::insert(const QContact &contact, const QContactFetchHint &hint)
+{
+    if (!isEnabled() || contact.id().isNull()) {
+        return;
+    }
+
+    // the entry is inserted again to update its cost
+    QHash<QString, QContact> *contacts = m_contacts.take(contact.id());
+    if (!contacts) {
+        contacts = new QHash<QString, QContact>;
+    }
+    contacts->insert(hintKey(hint), contact);
+    m_contacts.insert(contact.id(), contacts, contacts->size());
+}
+
+void GaleraContactCache::remove(const QList<QContactId> &ids)
+{
+    Q_FOREACH(const QContactId &id, ids) {
+        m_contacts.remove(id);
+    }
+}
+
+void GaleraContactCache::clear()
+{
+    m_contacts.clear();
+}
+
+QString GaleraContactCache::hintKey(const QContactFetchHint &hint)
+{
+    return FetchHint(hint).toString();
+}
+
+}
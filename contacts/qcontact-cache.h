@@ -0,0 +1,61 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_QCONTACT_CACHE_H__
+#define __GALERA_QCONTACT_CACHE_H__
+
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+#include <QtContacts/QContact>
+#include <QtContacts/QContactFetchHint>
+#include <QtContacts/QContactId>
+
+namespace galera
+{
+
+// Per process cache of the contacts fetched by id. The cache is disabled when
+// the max size is 0, each contact fetched with a different fetch hint counts as
+// one entry.
+class GaleraContactCache
+{
+public:
+    GaleraContactCache();
+
+    bool isEnabled() const;
+    void setMaxSize(int maxSize);
+
+    bool find(const QtContacts::QContactId &id,
+              const QtContacts::QContactFetchHint &hint,
+              QtContacts::QContact *contact) const;
+    void insert(const QtContacts::QContact &contact, const QtContacts::QContactFetchHint &hint);
+    void remove(const QList<QtContacts::QContactId> &ids);
+    void clear();
+
+private:
+    // contacts by id and fetch hint
+    QCache<QtContacts::QContactId, QHash<QString, QtContacts::QContact> > m_contacts;
+
+    static QString hintKey(const QtContacts::QContactFetchHint &hint);
+};
+
+}
+
+#endif
@@ -33,6 +33,8 @@ QContactFetchRequestData::QContactFetchRequestData(QContactAbstractRequest *requ
       m_runningParser(0),
       m_view(0),
       m_offset(0),
+      m_pageSize(1),
+      m_lastPageRequested(false),
       m_hint(hint)
 {
     if (view) {
@@ -51,6 +53,65 @@ int QContactFetchRequestData::offset() const
     return m_offset;
 }
 
+void QContactFetchRequestData::updatePageSize(int pageSize)
+{
+    m_pageSize = qMax(pageSize, 1);
+}
+
+int QContactFetchRequestData::pageSize() const
+{
+    return m_pageSize;
+}
+
+void QContactFetchRequestData::appendPage(QDBusPendingCallWatcher *watcher, int maxPageSize)
+{
+    Page page;
+    page.size = m_pageSize;
+    page.watcher = QSharedPointer<QDBusPendingCallWatcher>(watcher, QContactFetchRequestData::deletePageWatcher);
+    m_pages << page;
+
+    // the page size doubles on every request up to maxPageSize
+    m_offset += m_pageSize;
+    m_pageSize = qMax(qMin(m_pageSize * 2, maxPageSize), m_pageSize);
+}
+
+void QContactFetchRequestData::appendLastPage(QDBusPendingCallWatcher *watcher)
+{
+    Page page;
+    page.size = -1;
+    page.watcher = QSharedPointer<QDBusPendingCallWatcher>(watcher, QContactFetchRequestData::deletePageWatcher);
+    m_pages << page;
+    m_lastPageRequested = true;
+}
+
+QSharedPointer<QDBusPendingCallWatcher> QContactFetchRequestData::takePage(int *pageSize)
+{
+    Page page = m_pages.takeFirst();
+    *pageSize = page.size;
+    return page.watcher;
+}
+
+bool QContactFetchRequestData::isPageReady() const
+{
+    return !m_pages.isEmpty() && m_pages.first().watcher->isFinished();
+}
+
+int QContactFetchRequestData::pagesInFlight() const
+{
+    return m_pages.size();
+}
+
+void QContactFetchRequestData::setLastPageRequested()
+{
+    m_lastPageRequested = true;
+    m_pages.clear();
+}
+
+bool QContactFetchRequestData::isLastPageRequested() const
+{
+    return m_lastPageRequested;
+}
+
 QDBusInterface* QContactFetchRequestData::view() const
 {
     return m_view.data();
@@ -66,6 +127,11 @@ void QContactFetchRequestData::clearVCardParser()
     m_runningParser = 0;
 }
 
+bool QContactFetchRequestData::isParsing() const
+{
+    return (m_runningParser != 0);
+}
+
 void QContactFetchRequestData::updateView(QDBusInterface* view)
 {
     m_view = QSharedPointer<QDBusInterface>(view, QContactFetchRequestData::deleteView);
@@ -76,11 +142,6 @@ QStringList QContactFetchRequestData::fields() const
     return m_hint.fields();
 }
 
-void QContactFetchRequestData::updateOffset(int offset)
-{
-    m_offset += offset;
-}
-
 QList<QContact> QContactFetchRequestData::result() const
 {
     return m_result;
@@ -111,6 +172,7 @@ void QContactFetchRequestData::cancel()
     if (m_runningParser) {
         m_runningParser->cancel();
     }
+    m_pages.clear();
     QContactRequestData::cancel();
 }
 
@@ -149,4 +211,13 @@ void QContactFetchRequestData::deleteView(QDBusInterface *view)
     }
 }
 
+// the watcher can be released from its own finished signal
+void QContactFetchRequestData::deletePageWatcher(QDBusPendingCallWatcher *watcher)
+{
+    if (watcher) {
+        watcher->disconnect();
+        watcher->deleteLater();
+    }
+}
+
 } //namespace
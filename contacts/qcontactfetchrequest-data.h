@@ -30,6 +30,7 @@
 #include <QtContacts/QContactFetchRequest>
 
 #include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusPendingCallWatcher>
 
 namespace galera
 {
@@ -44,14 +45,28 @@ public:
 
     QStringList fields() const;
 
-    void updateOffset(int offset);
     int offset() const;
+    void updatePageSize(int pageSize);
+    int pageSize() const;
+
+    // pages requested to the view, they are parsed in the request order
+    void appendPage(QDBusPendingCallWatcher *watcher, int maxPageSize);
+    // the reply contains the full result
+    void appendLastPage(QDBusPendingCallWatcher *watcher);
+    QSharedPointer<QDBusPendingCallWatcher> takePage(int *pageSize);
+    bool isPageReady() const;
+    int pagesInFlight() const;
+
+    // the end of the view was found, pending requests after it are dropped
+    void setLastPageRequested();
+    bool isLastPageRequested() const;
 
     void updateView(QDBusInterface *view);
     QDBusInterface* view() const;
 
     void setVCardParser(VCardParser *parser);
     void clearVCardParser();
+    bool isParsing() const;
 
     QList<QtContacts::QContact> result() const;
 
@@ -77,12 +92,23 @@ protected:
                 QMap<int, QtContacts::QContactManager::Error> errorMap = QMap<int, QtContacts::QContactManager::Error>());
 
 private:
+    class Page
+    {
+    public:
+        int size;
+        QSharedPointer<QDBusPendingCallWatcher> watcher;
+    };
+
     VCardParser *m_runningParser;
     QSharedPointer<QDBusInterface> m_view;
+    QList<Page> m_pages;
     int m_offset;
+    int m_pageSize;
+    bool m_lastPageRequested;
     FetchHint m_hint;
 
     static void deleteView(QDBusInterface *view);
+    static void deletePageWatcher(QDBusPendingCallWatcher *watcher);
 };
 
 }
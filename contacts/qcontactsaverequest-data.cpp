@@ -81,15 +81,51 @@ bool QContactSaveRequestData::hasNextGroup() const
     return (m_pendingGroups.count() > 0);
 }
 
-QString QContactSaveRequestData::nextContact(QString *syncTargetName)
+QStringList QContactSaveRequestData::nextContacts(QString *syncTargetName)
 {
     Q_ASSERT(m_pendingContacts.count() > 0);
-    m_currentContact = m_pendingContacts.begin();
+    QString syncTarget = m_pendingContactsSyncTarget.begin().value();
+
+    QStringList vcards;
+    m_currentContacts.clear();
+    QMap<int, QString>::const_iterator i;
+    for (i = m_pendingContacts.constBegin(); i != m_pendingContacts.constEnd(); ++i) {
+        if (m_pendingContactsSyncTarget.value(i.key()) == syncTarget) {
+            m_currentContacts << i.key();
+            vcards << i.value();
+        }
+    }
 
     if (syncTargetName) {
-        *syncTargetName = m_pendingContactsSyncTarget.begin().value();
+        *syncTargetName = syncTarget;
     }
-    return m_currentContact.value();
+    return vcards;
+}
+
+void QContactSaveRequestData::updateCurrentContacts(const QList<QContact> &contacts)
+{
+    for (int i = 0; i < m_currentContacts.size(); i++) {
+        int key = m_currentContacts.at(i);
+        QContact contact = contacts.value(i);
+        if (contact.isEmpty()) {
+            m_errorMap.insert(key, QContactManager::UnspecifiedError);
+        } else {
+            m_contactsToCreate[key] = contact;
+        }
+        m_pendingContacts.remove(key);
+        m_pendingContactsSyncTarget.remove(key);
+    }
+    m_currentContacts.clear();
+}
+
+void QContactSaveRequestData::notifyCurrentContactsError(QContactManager::Error error)
+{
+    Q_FOREACH(int key, m_currentContacts) {
+        m_errorMap.insert(key, error);
+        m_pendingContacts.remove(key);
+        m_pendingContactsSyncTarget.remove(key);
+    }
+    m_currentContacts.clear();
 }
 
 Source QContactSaveRequestData::nextGroup()
@@ -100,13 +136,6 @@ Source QContactSaveRequestData::nextGroup()
     return *m_currentGroup;
 }
 
-void QContactSaveRequestData::updateCurrentContact(const QContact &contact)
-{
-    m_contactsToCreate[m_currentContact.key()] = contact;
-    m_pendingContacts.remove(m_currentContact.key());
-    m_pendingContactsSyncTarget.remove(m_currentContact.key());
-}
-
 void QContactSaveRequestData::updateCurrentGroup(const Source &group, const QString &managerUri)
 {
     QContactId id(managerUri, QByteArray("source@") + group.id().toUtf8());
@@ -114,6 +143,12 @@ void QContactSaveRequestData::updateCurrentGroup(const Source &group, const QStr
     m_pendingGroups.remove(m_currentGroup.key());
 }
 
+void QContactSaveRequestData::notifyCurrentGroupError(QContactManager::Error error)
+{
+    m_errorMap.insert(m_currentGroup.key(), error);
+    m_pendingGroups.remove(m_currentGroup.key());
+}
+
 void QContactSaveRequestData::updatePendingGroups(const SourceList &groups, const QString &managerUri)
 {
     if (groups.size() != m_pendingGroups.size()) {
@@ -146,19 +181,6 @@ void QContactSaveRequestData::updatePendingContacts(QStringList vcards)
     }
 }
 
-void QContactSaveRequestData::notifyUpdateError(QContactManager::Error error)
-{
-    m_contactsToUpdate.remove(m_currentContact.key());
-    m_errorMap.insert(m_currentContact.key(), error);
-    m_pendingContacts.remove(m_currentContact.key());
-    m_pendingContactsSyncTarget.remove(m_currentContact.key());
-}
-
-QContact QContactSaveRequestData::currentContact() const
-{
-    return qobject_cast<QContactSaveRequest*>(request())->contacts().at(m_currentContact.key());
-}
-
 QStringList QContactSaveRequestData::allPendingContacts() const
 {
     return m_pendingContacts.values();
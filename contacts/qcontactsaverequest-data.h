@@ -41,20 +41,22 @@ public:
 
 
     bool hasNext() const;
-    QString nextContact(QString *syncTargetName);
-    QtContacts::QContact currentContact() const;
     QStringList allPendingContacts() const;
-    void updateCurrentContact(const QtContacts::QContact &contact);
     void updatePendingContacts(QStringList vcards);
 
+    // pending contacts with the same sync target, created in a single call
+    QStringList nextContacts(QString *syncTargetName);
+    void updateCurrentContacts(const QList<QtContacts::QContact> &contacts);
+    void notifyCurrentContactsError(QtContacts::QContactManager::Error error);
+
     bool hasNextGroup() const;
     Source nextGroup();
     Source currentGroup() const;
     SourceList allPendingGroups() const;
     void updateCurrentGroup(const Source &group, const QString &managerUri);
+    void notifyCurrentGroupError(QtContacts::QContactManager::Error error);
     void updatePendingGroups(const SourceList &groups, const QString &managerUri);
 
-    void notifyUpdateError(QtContacts::QContactManager::Error error);
     void notifyError(QtContacts::QContactManager::Error error);
     static void notifyError(QtContacts::QContactSaveRequest *request,
                             QtContacts::QContactManager::Error error = QtContacts::QContactManager::NotSupportedError);
@@ -70,7 +72,7 @@ private:
 
     QMap<int, QString> m_pendingContacts;
     QMap<int, QString> m_pendingContactsSyncTarget;
-    QMap<int, QString>::Iterator m_currentContact;
+    QList<int> m_currentContacts;
 
     QMap<int, Source> m_pendingGroups;
     QMap<int, Source>::Iterator m_currentGroup;
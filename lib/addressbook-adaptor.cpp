@@ -116,6 +116,17 @@ QString AddressBookAdaptor::createContact(const QString &contact, const QString
     return QString();
 }
 
+QStringList AddressBookAdaptor::createContacts(const QStringList &contacts, const QString &source, const QDBusMessage &message)
+{
+    message.setDelayedReply(true);
+    QMetaObject::invokeMethod(m_addressBook, "createContacts",
+                              Qt::QueuedConnection,
+                              Q_ARG(const QStringList&, contacts),
+                              Q_ARG(const QString&, source),
+                              Q_ARG(const QDBusMessage&, message));
+    return QStringList();
+}
+
 QDBusObjectPath AddressBookAdaptor::query(const QString &clause, const QString &sort, int maxCount, bool showInvisible, const QStringList &sources)
 {
     View *v = m_addressBook->query(clause, sort, maxCount, showInvisible, sources);
@@ -123,6 +134,14 @@ QDBusObjectPath AddressBookAdaptor::query(const QString &clause, const QString &
     return QDBusObjectPath(v->dynamicObjectPath());
 }
 
+QStringList AddressBookAdaptor::queryPage(const QString &clause, const QString &sort, const QStringList &fields, int maxCount,
+                                          bool showInvisible, const QStringList &sources, const QDBusMessage &message)
+{
+    message.setDelayedReply(true);
+    m_addressBook->queryPage(clause, sort, fields, maxCount, showInvisible, sources, message);
+    return QStringList();
+}
+
 int AddressBookAdaptor::removeContacts(const QStringList &contactIds, const QDBusMessage &message)
 {
     message.setDelayedReply(true);
@@ -179,6 +198,12 @@ void AddressBookAdaptor::purgeContacts(const QString &since, const QString &sour
     m_addressBook->purgeContacts(sinceDate, sourceId, message);
 }
 
+qulonglong AddressBookAdaptor::changesSince(qulonglong revision, bool &resetRequired,
+                                            QStringList &added, QStringList &updated, QStringList &removed)
+{
+    return m_addressBook->changesSince(revision, &resetRequired, &added, &updated, &removed);
+}
+
 void AddressBookAdaptor::shutDown() const
 {
     m_addressBook->shutdown();
@@ -99,6 +99,15 @@ class AddressBookAdaptor: public QDBusAbstractAdaptor
 "      <arg direction=\"in\" type=\"as\" name=\"sources\"/>\n"
 "      <arg direction=\"out\" type=\"o\"/>\n"
 "    </method>\n"
+"    <method name=\"queryPage\">\n"
+"      <arg direction=\"in\" type=\"s\" name=\"clause\"/>\n"
+"      <arg direction=\"in\" type=\"s\" name=\"sort\"/>\n"
+"      <arg direction=\"in\" type=\"as\" name=\"fields\"/>\n"
+"      <arg direction=\"in\" type=\"i\" name=\"maxCount\"/>\n"
+"      <arg direction=\"in\" type=\"b\" name=\"showDiabledContacts\"/>\n"
+"      <arg direction=\"in\" type=\"as\" name=\"sources\"/>\n"
+"      <arg direction=\"out\" type=\"as\"/>\n"
+"    </method>\n"
 "    <method name=\"removeContacts\">\n"
 "      <arg direction=\"out\" type=\"i\"/>\n"
 "      <arg direction=\"in\" type=\"as\" name=\"contactIds\"/>\n"
@@ -108,6 +117,11 @@ class AddressBookAdaptor: public QDBusAbstractAdaptor
 "      <arg direction=\"in\" type=\"s\" name=\"source\"/>\n"
 "      <arg direction=\"out\" type=\"s\"/>\n"
 "    </method>\n"
+"    <method name=\"createContacts\">\n"
+"      <arg direction=\"in\" type=\"as\" name=\"contacts\"/>\n"
+"      <arg direction=\"in\" type=\"s\" name=\"source\"/>\n"
+"      <arg direction=\"out\" type=\"as\"/>\n"
+"    </method>\n"
 "    <method name=\"updateContacts\">\n"
 "      <arg direction=\"out\" type=\"as\"/>\n"
 "      <arg direction=\"in\" type=\"as\" name=\"contacts\"/>\n"
@@ -121,6 +135,14 @@ class AddressBookAdaptor: public QDBusAbstractAdaptor
 "      <arg direction=\"in\" type=\"s\" name=\"parent\"/>\n"
 "      <arg direction=\"in\" type=\"as\" name=\"contacts\"/>\n"
 "    </method>\n"
+"    <method name=\"changesSince\">\n"
+"      <arg direction=\"in\" type=\"t\" name=\"revision\"/>\n"
+"      <arg direction=\"out\" type=\"t\" name=\"currentRevision\"/>\n"
+"      <arg direction=\"out\" type=\"b\" name=\"resetRequired\"/>\n"
+"      <arg direction=\"out\" type=\"as\" name=\"added\"/>\n"
+"      <arg direction=\"out\" type=\"as\" name=\"updated\"/>\n"
+"      <arg direction=\"out\" type=\"as\" name=\"removed\"/>\n"
+"    </method>\n"
 "    <method name=\"purgeContacts\">\n"
 "      <arg direction=\"in\" type=\"s\"/>\n"
 "      <arg direction=\"in\" type=\"s\"/>\n"
@@ -149,8 +171,11 @@ public Q_SLOTS:
     bool removeSource(const QString &sourceId, const QDBusMessage &message);
     QStringList sortFields();
     QDBusObjectPath query(const QString &clause, const QString &sort, int maxCount, bool showInvisible, const QStringList &sources);
+    QStringList queryPage(const QString &clause, const QString &sort, const QStringList &fields, int maxCount,
+                          bool showInvisible, const QStringList &sources, const QDBusMessage &message);
     int removeContacts(const QStringList &contactIds, const QDBusMessage &message);
     QString createContact(const QString &contact, const QString &source, const QDBusMessage &message);
+    QStringList createContacts(const QStringList &contacts, const QString &source, const QDBusMessage &message);
     QStringList updateContacts(const QStringList &contacts, const QDBusMessage &message);
     QString linkContacts(const QStringList &contacts);
     bool unlinkContacts(const QString &parentId, const QStringList &contactsIds);
@@ -158,6 +183,8 @@ public Q_SLOTS:
     bool safeMode() const;
     bool ping();
     void purgeContacts(const QString &since, const QString &sourceId, const QDBusMessage &message);
+    qulonglong changesSince(qulonglong revision, bool &resetRequired,
+                            QStringList &added, QStringList &updated, QStringList &removed);
     void shutDown() const;
 
 
@@ -21,6 +21,7 @@
 #include "addressbook-adaptor.h"
 #include "view.h"
 #include "contacts-map.h"
+#include "contacts-snapshot-file.h"
 #include "qindividual.h"
 #include "dirtycontact-notify.h"
 #include "e-source-ubuntu.h"
@@ -47,6 +48,12 @@ namespace C {
 }
 
 #define MESSAGING_MENU_SOURCE_ID "address-book-service"
+// number of folks add operations running at same time for a createContacts call
+#define CREATE_CONTACTS_MAX_RUNNING 8
+// number of contacts being updated at same time for all updateContacts calls
+#define UPDATE_CONTACTS_MAX_RUNNING 8
+// time in ms between the contacts changes and the snapshot save
+#define SNAPSHOT_SAVE_INTERVAL 30000
 
 using namespace QtContacts;
 
@@ -61,14 +68,36 @@ public:
     galera::AddressBook *m_addressbook;
 };
 
-class UpdateContactsData
+class CreateContactsData
 {
 public:
+    QDBusMessage m_message;
     QList<QContact> m_contacts;
-    QStringList m_request;
-    int m_currentIndex;
+    // the new contact vCard or a empty string for the contacts that failed
     QStringList m_result;
+    FolksPersonaStore *m_store;
+    int m_next;
+    int m_running;
     galera::AddressBook *m_addressbook;
+};
+
+class CreateContactsItemData
+{
+public:
+    CreateContactsData *m_batch;
+    int m_index;
+};
+
+class UpdateContactsData
+{
+public:
+    QList<QContact> m_contacts;
+    // index of the contacts waiting to start the update
+    QList<int> m_pending;
+    int m_running;
+    // the updated contact vCard or the error message
+    QStringList m_result;
+    QSet<QString> m_updatedIds;
     QDBusMessage m_message;
 };
 
@@ -169,6 +198,8 @@ AddressBook::AddressBook(QObject *parent)
       m_individualsChangedDetailedId(0),
       m_notifyIsQuiescentHandlerId(0),
       m_connection(QDBusConnection::sessionBus()),
+      m_schedulingUpdates(false),
+      m_snapshotLoader(0),
       m_messagingMenu(0),
       m_messagingMenuMessage(0),
       m_sourceRegistryListener(0)
@@ -183,6 +214,10 @@ AddressBook::AddressBook(QObject *parent)
     connectWithEDS();
     connect(this, SIGNAL(readyChanged()), SLOT(checkCompatibility()));
     connect(this, SIGNAL(safeModeChanged()), SLOT(onSafeModeChanged()));
+
+    m_snapshotTimer.setSingleShot(true);
+    m_snapshotTimer.setInterval(SNAPSHOT_SAVE_INTERVAL);
+    connect(&m_snapshotTimer, SIGNAL(timeout()), SLOT(saveSnapshot()));
 }
 
 AddressBook::~AddressBook()
@@ -214,6 +249,16 @@ AddressBook::~AddressBook()
         delete m_notifyContactUpdate;
         m_notifyContactUpdate = 0;
     }
+
+    if (m_snapshotLoader) {
+        m_snapshotLoader->wait();
+        delete m_snapshotLoader;
+        m_snapshotLoader = 0;
+    }
+
+    qDeleteAll(m_updateQueue);
+    m_updateQueue.clear();
+    m_runningUpdates.clear();
 }
 
 QString AddressBook::objectPath()
@@ -246,6 +291,9 @@ bool AddressBook::registerObject(QDBusConnection &connection)
     }
     if (m_adaptor) {
         m_notifyContactUpdate = new DirtyContactsNotify(m_adaptor);
+        connect(m_adaptor, SIGNAL(contactsAdded(QStringList)), SLOT(scheduleSnapshot()));
+        connect(m_adaptor, SIGNAL(contactsRemoved(QStringList)), SLOT(scheduleSnapshot()));
+        connect(m_adaptor, SIGNAL(contactsUpdated(QStringList)), SLOT(scheduleSnapshot()));
     }
     return (m_adaptor != 0);
 }
@@ -274,6 +322,15 @@ void AddressBook::unprepareFolks()
     // flusing any pending notification
     m_notifyContactUpdate->flush();
 
+    // keep the last changes for the next start
+    if (m_snapshotTimer.isActive()) {
+        m_snapshotTimer.stop();
+        QString path = ContactsSnapshotFile::path();
+        if (m_ready && m_contacts && !path.isEmpty()) {
+            ContactsSnapshotFile::save(path, *m_contacts->snapshot());
+        }
+    }
+
     setIsReady(false);
 
     Q_FOREACH(View* view, m_views) {
@@ -376,6 +433,18 @@ void AddressBook::setIsReady(bool isReady)
 {
     if (isReady != m_ready) {
         m_ready = isReady;
+        if (m_ready && m_notifyContactUpdate) {
+            // changes done while the service was not ready were not notified
+            m_notifyContactUpdate->journal()->reset();
+        }
+        if (m_ready && m_contacts) {
+            // views created before folks was ready run again on the live contacts
+            Q_FOREACH(View *view, m_views) {
+                view->setContactsMap(m_contacts);
+            }
+            m_bootSnapshot.clear();
+            scheduleSnapshot();
+        }
         if (m_adaptor) {
             Q_EMIT readyChanged();
         }
@@ -389,6 +458,16 @@ void AddressBook::prepareFolks()
     m_individualAggregator = folks_individual_aggregator_dup();
     gboolean ready;
     g_object_get(G_OBJECT(m_individualAggregator), "is-quiescent", &ready, NULL);
+    if (!ready) {
+        // folks delivers the initial contacts in large batches until it becomes quiescent
+        m_contacts->beginBulkLoad();
+        // the snapshot is loaded in a separated thread to not delay the service start
+        QString snapshotPath = ContactsSnapshotFile::path();
+        if (!m_snapshotLoader && !snapshotPath.isEmpty()) {
+            m_snapshotLoader = new ContactsSnapshotLoader(snapshotPath, this, "bootSnapshotLoaded");
+            m_snapshotLoader->start();
+        }
+    }
     m_notifyIsQuiescentHandlerId = g_signal_connect(m_individualAggregator,
                                           "notify::is-quiescent",
                                           (GCallback) AddressBook::isQuiescentChanged,
@@ -1096,6 +1175,76 @@ QString AddressBook::createContact(const QString &contact, const QString &source
     return "";
 }
 
+QStringList AddressBook::createContacts(const QStringList &contacts, const QString &source, const QDBusMessage &message)
+{
+    CreateContactsData *data = new CreateContactsData;
+    data->m_message = message;
+    data->m_addressbook = this;
+    data->m_next = 0;
+    data->m_running = 0;
+    data->m_store = getFolksStore(source);
+
+    // parse all vCards at once, fallback to one by one if any vCard is invalid
+    data->m_contacts = VCardParser::vcardToContactSync(contacts);
+    if (data->m_contacts.size() != contacts.size()) {
+        data->m_contacts.clear();
+        Q_FOREACH(const QString &contact, contacts) {
+            data->m_contacts << VCardParser::vcardToContact(contact);
+        }
+    }
+
+    for (int i = 0; i < contacts.size(); i++) {
+        data->m_result << QString();
+        if (m_contacts->valueFromVCard(contacts.at(i))) {
+            qWarning() << "Contact exists";
+            data->m_contacts[i] = QContact();
+        }
+    }
+
+    createContactsNext(data);
+    return QStringList();
+}
+
+void AddressBook::createContactsNext(void *data)
+{
+    CreateContactsData *createData = static_cast<CreateContactsData*>(data);
+
+    while ((createData->m_running < CREATE_CONTACTS_MAX_RUNNING) &&
+           (createData->m_next < createData->m_contacts.size())) {
+        int index = createData->m_next++;
+        const QContact &qcontact = createData->m_contacts.at(index);
+        if (qcontact.isEmpty()) {
+            continue;
+        }
+
+        GHashTable *details = QIndividual::parseDetails(qcontact);
+        Q_ASSERT(details);
+        CreateContactsItemData *itemData = new CreateContactsItemData;
+        itemData->m_batch = createData;
+        itemData->m_index = index;
+        createData->m_running++;
+        folks_individual_aggregator_add_persona_from_details(m_individualAggregator,
+                                                             NULL, //parent
+                                                             createData->m_store,
+                                                             details,
+                                                             (GAsyncReadyCallback) createContactsItemDone,
+                                                             (void*) itemData);
+        g_hash_table_destroy(details);
+    }
+
+    if ((createData->m_running == 0) &&
+        (createData->m_next >= createData->m_contacts.size())) {
+        if (createData->m_message.type() != QDBusMessage::InvalidMessage) {
+            QDBusMessage reply = createData->m_message.createReply(createData->m_result);
+            QDBusConnection::sessionBus().send(reply);
+        }
+        if (createData->m_store) {
+            g_object_unref(createData->m_store);
+        }
+        delete createData;
+    }
+}
+
 FolksPersonaStore * AddressBook::getFolksStore(const QString &source)
 {
     QString sourceId(source);
@@ -1163,12 +1312,75 @@ QString AddressBook::linkContacts(const QStringList &contacts)
 
 View *AddressBook::query(const QString &clause, const QString &sort, int maxCount, bool showInvisible, const QStringList &sources)
 {
-    View *view = new View(clause, sort, maxCount, showInvisible, sources, m_ready ? m_contacts : 0, this);
+    View *view = new View(clause, sort, maxCount, showInvisible, sources,
+                          m_ready ? m_contacts : 0, m_bootSnapshot, this);
     m_views << view;
     connect(view, SIGNAL(closed()), this, SLOT(viewClosed()));
     return view;
 }
 
+void AddressBook::queryPage(const QString &clause, const QString &sort, const QStringList &fields, int maxCount,
+                            bool showInvisible, const QStringList &sources, const QDBusMessage &message)
+{
+    if (!m_ready && !m_bootSnapshot) {
+        QDBusConnection::sessionBus().send(message.createReply(QStringList()));
+        return;
+    }
+
+    // the view is not registered on the bus, it is destroyed after the reply
+    View *view = new View(clause, sort, maxCount, showInvisible, sources,
+                          m_ready ? m_contacts : 0, m_bootSnapshot, this);
+    view->replyFirstPage(fields, maxCount, message);
+}
+
+quint64 AddressBook::changesSince(quint64 revision, bool *resetRequired,
+                                  QStringList *added, QStringList *updated, QStringList *removed)
+{
+    if (!m_notifyContactUpdate) {
+        *resetRequired = true;
+        return 0;
+    }
+
+    ChangeJournal *journal = m_notifyContactUpdate->journal();
+    *resetRequired = !journal->changesSince(revision, added, updated, removed);
+    return journal->revision();
+}
+
+void AddressBook::scheduleSnapshot()
+{
+    // save at most once per interval
+    if (!m_snapshotTimer.isActive()) {
+        m_snapshotTimer.start();
+    }
+}
+
+void AddressBook::saveSnapshot()
+{
+    QString path = ContactsSnapshotFile::path();
+    if (m_ready && m_contacts && !path.isEmpty()) {
+        ContactsSnapshotFile::saveAsync(path, m_contacts->snapshot());
+    }
+}
+
+void AddressBook::bootSnapshotLoaded()
+{
+    if (!m_snapshotLoader) {
+        return;
+    }
+
+    m_snapshotLoader->wait();
+    QSharedPointer<const ContactsSnapshot> snapshot = m_snapshotLoader->result();
+    delete m_snapshotLoader;
+    m_snapshotLoader = 0;
+
+    // the snapshot is not necessary if folks is ready already, views created before
+    // the load keep waiting for folks
+    if (!m_ready && snapshot) {
+        qDebug() << "Using contacts snapshot until folks is ready:" << snapshot->entries.size();
+        m_bootSnapshot = snapshot;
+    }
+}
+
 void AddressBook::viewClosed()
 {
     m_views.remove(qobject_cast<View*>(QObject::sender()));
@@ -1176,6 +1388,15 @@ void AddressBook::viewClosed()
 
 void AddressBook::individualChanged(QIndividual *individual)
 {
+    // contacts changed by updateContacts() are moved when the update finishes
+    ContactEntry *entry = m_runningUpdates.contains(individual->id()) ? 0 : m_contacts->value(individual->id());
+    if (entry) {
+        m_contacts->updatePosition(entry);
+        Q_FOREACH(View *view, m_views) {
+            view->updateContact(entry);
+        }
+    }
+
     if (individual->isVisible()) {
         m_notifyContactUpdate->insertChangedContacts(QSet<QString>() << individual->id());
     }
@@ -1269,6 +1490,10 @@ void AddressBook::removeContactDone(FolksIndividualAggregator *individualAggrega
         ContactEntry *entry = removeData->m_addressbook->m_contacts->value(contactId);
         if (entry) {
             if (removeData->m_softRemoval && entry->individual()->markAsDeleted()) {
+                removeData->m_addressbook->m_contacts->updatePosition(entry);
+                Q_FOREACH(View *view, removeData->m_addressbook->m_views) {
+                    view->updateContact(entry);
+                }
                 removeContactDone(individualAggregator, 0, data);
                 // since this will not be removed we need to send a removal singal
                 removeData->m_addressbook->m_notifyContactUpdate->insertRemovedContacts(QSet<QString>() << entry->individual()->id());
@@ -1306,21 +1531,26 @@ bool AddressBook::isReady() const
 
 QStringList AddressBook::updateContacts(const QStringList &contacts, const QDBusMessage &message)
 {
-    //TODO: support multiple update contacts calls
-    Q_ASSERT(m_updateCommandPendingContacts.isEmpty());
-    if (!processUpdates()) {
-        qWarning() << "Fail to process pending updates";
-        QDBusMessage reply = m_updateCommandReplyMessage.createReply(QStringList());
-        QDBusConnection::sessionBus().send(reply);
-        return QStringList();
+    UpdateContactsData *data = new UpdateContactsData;
+    data->m_message = message;
+    data->m_result = contacts;
+    data->m_running = 0;
+
+    // parse all vCards at once, fallback to one by one if any vCard is invalid
+    data->m_contacts = VCardParser::vcardToContactSync(contacts);
+    if (data->m_contacts.size() != contacts.size()) {
+        data->m_contacts.clear();
+        Q_FOREACH(const QString &contact, contacts) {
+            data->m_contacts << VCardParser::vcardToContact(contact);
+        }
     }
 
-    m_updatedIds.clear();
-    m_updateCommandReplyMessage = message;
-    m_updateCommandResult = contacts;
-    m_updateCommandPendingContacts = contacts;
+    for (int i = 0; i < contacts.size(); i++) {
+        data->m_pending << i;
+    }
 
-    updateContactsDone("", "");
+    m_updateQueue << data;
+    updateContactsNext();
     return QStringList();
 }
 
@@ -1347,56 +1577,106 @@ void AddressBook::purgeContacts(const QDateTime &since, const QString &sourceId,
 void AddressBook::updateContactsDone(const QString &contactId,
                                      const QString &error)
 {
-    int currentContactIndex = m_updateCommandResult.size() - m_updateCommandPendingContacts.size() - 1;
+    QPair<UpdateContactsData*, int> item = m_runningUpdates.take(contactId);
+    if (!item.first) {
+        qWarning() << "Update done for a unknown contact" << contactId;
+        return;
+    }
+
+    updateContactsItemDone(item.first, item.second, contactId, error);
+    if (!m_schedulingUpdates) {
+        updateContactsNext();
+    }
+}
 
+void AddressBook::updateContactsItemDone(UpdateContactsData *data,
+                                         int index,
+                                         const QString &contactId,
+                                         const QString &error)
+{
+    data->m_running--;
     if (!error.isEmpty()) {
         // update the result with the error
-        if (currentContactIndex >= 0 &&
-            currentContactIndex < m_updateCommandResult.size()) {
-            m_updateCommandResult[currentContactIndex] = error;
-        } else {
-            qWarning() << "Invalid contact changed index" << currentContactIndex <<
-                          "Contact list size" << m_updateCommandResult.size();
-        }
-    } else if (!contactId.isEmpty()){
-        // update the result with the new contact info
-        ContactEntry *entry = m_contacts->value(contactId);
-        Q_ASSERT(entry);
-        m_updatedIds << contactId;
-        QContact contact = entry->individual()->contact();
-        QString vcard = VCardParser::contactToVcard(contact);
-        if (!vcard.isEmpty()) {
-            m_updateCommandResult[currentContactIndex] = vcard;
-        } else {
-            m_updateCommandResult[currentContactIndex] = "";
+        data->m_result[index] = error;
+        return;
+    }
+
+    ContactEntry *entry = m_contacts->value(contactId);
+    if (!entry) {
+        data->m_result[index] = "Contact not found!";
+        return;
+    }
+
+    // update the result with the new contact info
+    data->m_updatedIds << contactId;
+    data->m_result[index] = entry->individual()->vcard();
+
+    // update contact position on map
+    m_contacts->updatePosition(entry);
+    Q_FOREACH(View *view, m_views) {
+        view->updateContact(entry);
+    }
+}
+
+void AddressBook::updateContactsNext()
+{
+    // updates finished during the loop are processed by the loop itself
+    m_schedulingUpdates = true;
+
+    // the updates of the same contact run in the order that they were requested
+    QSet<QString> blockedIds;
+    Q_FOREACH(UpdateContactsData *data, m_updateQueue) {
+        int i = 0;
+        while ((i < data->m_pending.size()) &&
+               (m_runningUpdates.size() < UPDATE_CONTACTS_MAX_RUNNING)) {
+            int index = data->m_pending.at(i);
+            const QContact &newContact = data->m_contacts.at(index);
+            QString contactId = newContact.detail<QContactGuid>().guid();
+            if (m_runningUpdates.contains(contactId) || blockedIds.contains(contactId)) {
+                blockedIds << contactId;
+                i++;
+                continue;
+            }
+
+            data->m_pending.removeAt(i);
+            data->m_running++;
+
+            ContactEntry *entry = m_contacts->value(contactId);
+            if (!entry) {
+                qWarning() << "Contact not found for update:" << data->m_result.at(index);
+                updateContactsItemDone(data, index, contactId, "Contact not found!");
+                continue;
+            }
+
+            m_runningUpdates.insert(contactId, qMakePair(data, index));
+            if (!entry->individual()->update(newContact, this,
+                                             SLOT(updateContactsDone(QString,QString))) &&
+                m_runningUpdates.contains(contactId)) {
+                // the contact did not change
+                m_runningUpdates.remove(contactId);
+                data->m_running--;
+                data->m_result[index] = entry->individual()->vcard();
+            }
         }
-        // update contact position on map
-        m_contacts->updatePosition(entry);
     }
 
-    if (!m_updateCommandPendingContacts.isEmpty()) {
-        QString vCard = m_updateCommandPendingContacts.takeFirst();
-        QContact newContact = VCardParser::vcardToContact(vCard);
-        ContactEntry *entry = m_contacts->value(newContact.detail<QContactGuid>().guid());
-        if (entry) {
-            entry->individual()->update(newContact, this,
-                                        SLOT(updateContactsDone(QString,QString)));
-        } else {
-            qWarning() << "Contact not found for update:" << vCard;
-            updateContactsDone("", "Contact not found!");
+    m_schedulingUpdates = false;
+
+    // reply the calls with all contacts updated
+    Q_FOREACH(UpdateContactsData *data, m_updateQueue) {
+        if (!data->m_pending.isEmpty() || (data->m_running > 0)) {
+            continue;
         }
-    } else {
-        QDBusMessage reply = m_updateCommandReplyMessage.createReply(m_updateCommandResult);
-        QDBusConnection::sessionBus().send(reply);
 
-        // notify about the changes
-        m_notifyContactUpdate->insertChangedContacts(m_updatedIds.toSet());
+        m_updateQueue.removeOne(data);
+        if (data->m_message.type() != QDBusMessage::InvalidMessage) {
+            QDBusMessage reply = data->m_message.createReply(data->m_result);
+            QDBusConnection::sessionBus().send(reply);
+        }
 
-        // clear command data
-        m_updatedIds.clear();
-        m_updateCommandResult.clear();
-        m_updateCommandReplyMessage = QDBusMessage();
-        m_updateLock.unlock();
+        // notify about the changes
+        m_notifyContactUpdate->insertChangedContacts(data->m_updatedIds);
+        delete data;
     }
 }
 
@@ -1405,7 +1685,17 @@ QString AddressBook::removeContact(FolksIndividual *individual, bool *visible)
     QString contactId = QString::fromUtf8(folks_individual_get_id(individual));
     ContactEntry *ci = m_contacts->take(contactId);
     if (ci) {
+        // the update of a destroyed individual never finishes
+        QPair<UpdateContactsData*, int> item = m_runningUpdates.take(contactId);
+        if (item.first) {
+            updateContactsItemDone(item.first, item.second, contactId, "Contact removed during the update");
+            QMetaObject::invokeMethod(this, "updateContactsNext", Qt::QueuedConnection);
+        }
+
         *visible = ci->individual()->isVisible();
+        Q_FOREACH(View *view, m_views) {
+            view->removeContact(ci);
+        }
         delete ci;
         return contactId;
     }
@@ -1422,12 +1712,18 @@ QString AddressBook::addContact(FolksIndividual *individual, bool visible)
 
         // update contact position on map
         m_contacts->updatePosition(entry);
+        Q_FOREACH(View *view, m_views) {
+            view->updateContact(entry);
+        }
     } else {
         QIndividual *i = new QIndividual(individual, m_individualAggregator);
         i->addListener(this, SLOT(individualChanged(QIndividual*)));
         i->setVisible(visible);
-        m_contacts->insert(new ContactEntry(i));
-        //TODO: Notify view
+        entry = new ContactEntry(i);
+        m_contacts->insert(entry);
+        Q_FOREACH(View *view, m_views) {
+            view->appendContact(entry);
+        }
     }
 
     return id;
@@ -1530,6 +1826,39 @@ void AddressBook::prepareFolksDone(GObject *source,
     Q_UNUSED(self);
 }
 
+void AddressBook::createContactsItemDone(FolksIndividualAggregator *individualAggregator,
+                                         GAsyncResult *res,
+                                         void *data)
+{
+    CreateContactsItemData *itemData = static_cast<CreateContactsItemData*>(data);
+    CreateContactsData *createData = itemData->m_batch;
+
+    GError *error = NULL;
+    FolksPersona *persona = folks_individual_aggregator_add_persona_from_details_finish(individualAggregator, res, &error);
+    if (error != NULL) {
+        qWarning() << "Failed to create individual from contact:" << error->message;
+        g_clear_error(&error);
+    } else if (persona == NULL) {
+        qWarning() << "Failed to create individual from contact: Persona already exists";
+    } else {
+        const QContact &qcontact = createData->m_contacts.at(itemData->m_index);
+        QIndividual::setExtendedDetails(persona,
+                                        qcontact.details(QContactExtendedDetail::Type),
+                                        QDateTime::currentDateTime());
+        FolksIndividual *individual = folks_persona_get_individual(persona);
+        ContactEntry *entry = createData->m_addressbook->m_contacts->value(QString::fromUtf8(folks_individual_get_id(individual)));
+        if (entry) {
+            // We will need to reload contact due the extended details
+            entry->individual()->flush();
+            createData->m_result[itemData->m_index] = entry->individual()->vcard();
+        }
+    }
+
+    delete itemData;
+    createData->m_running--;
+    createData->m_addressbook->createContactsNext(createData);
+}
+
 void AddressBook::createContactDone(FolksIndividualAggregator *individualAggregator,
                                     GAsyncResult *res,
                                     void *data)
@@ -1556,7 +1885,7 @@ void AddressBook::createContactDone(FolksIndividualAggregator *individualAggrega
         if (entry) {
             // We will need to reload contact due the extended details
             entry->individual()->flush();
-            QString vcard = VCardParser::contactToVcard(entry->individual()->contact());
+            QString vcard = entry->individual()->vcard();
             if (createData->m_message.type() != QDBusMessage::InvalidMessage) {
                 reply = createData->m_message.createReply(vcard);
             }
@@ -1577,6 +1906,9 @@ void AddressBook::isQuiescentChanged(GObject *source, GParamSpec *param, Address
     gboolean ready = false;
     g_object_get(source, "is-quiescent", &ready, NULL);
     if (self) {
+        if (ready && self->m_contacts) {
+            self->m_contacts->endBulkLoad();
+        }
         self->setIsReady(ready);
     }
 }
@@ -1587,19 +1919,6 @@ void AddressBook::quitSignalHandler(int)
      ::write(m_sigQuitFd[0], &a, sizeof(a));
 }
 
-bool AddressBook::processUpdates()
-{
-    int timeout = 10;
-    while(!m_updateLock.tryLock(1000)) {
-        if (timeout <= 0) {
-            return false;
-        }
-        QCoreApplication::processEvents();
-        timeout--;
-    }
-    return true;
-}
-
 int AddressBook::init()
 {
     struct sigaction quit = { { 0 } };
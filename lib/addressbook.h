@@ -21,11 +21,15 @@
 
 #include "common/source.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QPair>
 #include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QSettings>
+#include <QtCore/QTimer>
 
 #include <QtDBus/QtDBus>
 
@@ -40,10 +44,14 @@ typedef struct _MessagingMenuApp MessagingMenuApp;
 typedef struct _ESource ESource;
 typedef struct _ESourceRegistry ESourceRegistry;
 
+class UpdateContactsData;
+
 namespace galera
 {
 class View;
 class ContactsMap;
+class ContactsSnapshot;
+class ContactsSnapshotLoader;
 class AddressBookAdaptor;
 class QIndividual;
 class DirtyContactsNotify;
@@ -61,8 +69,14 @@ public:
     // Adaptor
     QString linkContacts(const QStringList &contacts);
     View *query(const QString &clause, const QString &sort, int maxCount, bool showInvisible, const QStringList &sources);
+    void queryPage(const QString &clause, const QString &sort, const QStringList &fields, int maxCount,
+                   bool showInvisible, const QStringList &sources, const QDBusMessage &message);
     QStringList sortFields();
     bool unlinkContacts(const QString &parent, const QStringList &contacts);
+    // changes notified after 'revision', returns the current revision; revisions
+    // returned by other service instances always require a reset
+    quint64 changesSince(quint64 revision, bool *resetRequired,
+                         QStringList *added, QStringList *updated, QStringList *removed);
     bool isReady() const;
     void setSafeMode(bool flag);
 
@@ -84,6 +98,7 @@ public Q_SLOTS:
     SourceList updateSources(const SourceList &sources, const QDBusMessage &message);
     void removeSource(const QString &sourceId, const QDBusMessage &message);
     QString createContact(const QString &contact, const QString &source, const QDBusMessage &message = QDBusMessage());
+    QStringList createContacts(const QStringList &contacts, const QString &source, const QDBusMessage &message);
     int removeContacts(const QStringList &contactIds, const QDBusMessage &message);
     QStringList updateContacts(const QStringList &contacts, const QDBusMessage &message);
     void purgeContacts(const QDateTime &since, const QString &sourceId, const QDBusMessage &message);
@@ -105,6 +120,14 @@ private Q_SLOTS:
     // check compatibility and if the safe mode should be enabled
     void checkCompatibility();
 
+    // start the queued updates
+    void updateContactsNext();
+
+    // save the contacts snapshot used by the next service start
+    void scheduleSnapshot();
+    void saveSnapshot();
+    void bootSnapshotLoaded();
+
 private:
     FolksIndividualAggregator *m_individualAggregator;
     ContactsMap *m_contacts;
@@ -127,11 +150,15 @@ private:
     QDBusConnection m_connection;
 
     // Update command
-    QMutex m_updateLock;
-    QDBusMessage m_updateCommandReplyMessage;
-    QStringList m_updateCommandResult;
-    QStringList m_updatedIds;
-    QStringList m_updateCommandPendingContacts;
+    QList<UpdateContactsData*> m_updateQueue;
+    // running updates by contact id
+    QHash<QString, QPair<UpdateContactsData*, int> > m_runningUpdates;
+    bool m_schedulingUpdates;
+
+    // contacts saved by the last service instance, used by the queries until folks is ready
+    QSharedPointer<const ContactsSnapshot> m_bootSnapshot;
+    ContactsSnapshotLoader *m_snapshotLoader;
+    QTimer m_snapshotTimer;
 
     // Unix signals
     static int m_sigQuitFd[2];
@@ -151,7 +178,6 @@ private:
     void prepareUnixSignals();
     static void quitSignalHandler(int unused);
 
-    bool processUpdates();
     void prepareFolks();
     void unprepareEds();
     void connectWithEDS();
@@ -161,6 +187,8 @@ private:
     QString removeContact(FolksIndividual *individual, bool *visible);
     QString addContact(FolksIndividual *individual, bool visible);
     FolksPersonaStore *getFolksStore(const QString &source);
+    void createContactsNext(void *data);
+    void updateContactsItemDone(UpdateContactsData *data, int index, const QString &contactId, const QString &error);
 
     static void availableSourcesDoneListAllSources(FolksBackendStore *backendStore,
                                                    GAsyncResult *res,
@@ -182,6 +210,9 @@ private:
     static void createContactDone(FolksIndividualAggregator *individualAggregator,
                                   GAsyncResult *res,
                                   void *data);
+    static void createContactsItemDone(FolksIndividualAggregator *individualAggregator,
+                                       GAsyncResult *res,
+                                       void *data);
     static void removeContactDone(FolksIndividualAggregator *individualAggregator,
                                   GAsyncResult *result,
                                   void *data);
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "change-journal.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QUuid>
+
+namespace
+{
+    // contact added and removed after the requested revision
+    const int Dropped = -1;
+
+    // random value to identify the revisions of this journal instance, the
+    // previous instances of the service may have returned any counter value
+    quint32 newEpoch(quint32 previous)
+    {
+        quint32 epoch = previous;
+        while ((epoch == 0) || (epoch == previous)) {
+            epoch = QUuid::createUuid().data1;
+        }
+        return epoch;
+    }
+}
+
+namespace galera
+{
+
+ChangeJournal::ChangeJournal(int capacity)
+    : m_changes(qMax(1, capacity)),
+      m_first(0),
+      m_size(0),
+      m_epoch(newEpoch(0)),
+      m_counter(0)
+{
+}
+
+void ChangeJournal::append(Operation operation, const QSet<QString> &ids)
+{
+    Q_FOREACH(const QString &id, ids) {
+        int pos = (m_first + m_size) % m_changes.size();
+        if (m_size == m_changes.size()) {
+            // overwrite the oldest change
+            m_first = (m_first + 1) % m_changes.size();
+        } else {
+            m_size++;
+        }
+        m_changes[pos].operation = operation;
+        m_changes[pos].id = id;
+        if (m_counter == 0xffffffff) {
+            // the counter can not grow anymore, clients must query all contacts again
+            reset();
+        } else {
+            m_counter++;
+        }
+    }
+}
+
+void ChangeJournal::reset()
+{
+    m_first = 0;
+    m_size = 0;
+    // the revisions returned before the reset belong to another epoch
+    m_epoch = newEpoch(m_epoch);
+    m_counter = 0;
+}
+
+quint64 ChangeJournal::revision() const
+{
+    return (quint64(m_epoch) << 32) | m_counter;
+}
+
+bool ChangeJournal::changesSince(quint64 revision, QStringList *added, QStringList *updated, QStringList *removed) const
+{
+    // revisions from another service instance or journal reset
+    if (quint32(revision >> 32) != m_epoch) {
+        return false;
+    }
+
+    // revisions from the future or older than the first change available
+    const quint32 counter = quint32(revision & 0xffffffff);
+    if ((counter > m_counter) || (counter < (m_counter - m_size))) {
+        return false;
+    }
+
+    // merge all operations of the same contact
+    QHash<QString, int> operations;
+    QStringList ids;
+    for (int i = m_size - int(m_counter - counter); i < m_size; i++) {
+        const Change &change = m_changes.at((m_first + i) % m_changes.size());
+        QHash<QString, int>::iterator it = operations.find(change.id);
+        if (it == operations.end()) {
+            operations.insert(change.id, change.operation);
+            ids << change.id;
+            continue;
+        }
+
+        switch (change.operation) {
+        case Added:
+            // removed and added again
+            *it = (*it == Removed) ? Updated : Added;
+            break;
+        case Updated:
+            // the client does not know about the contact or it is already marked as changed
+            break;
+        case Removed:
+            *it = (*it == Added) ? Dropped : Removed;
+            break;
+        }
+    }
+
+    Q_FOREACH(const QString &id, ids) {
+        switch (operations.value(id)) {
+        case Added:
+            *added << id;
+            break;
+        case Updated:
+            *updated << id;
+            break;
+        case Removed:
+            *removed << id;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+} //namespace
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_CHANGE_JOURNAL_H__
+#define __GALERA_CHANGE_JOURNAL_H__
+
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+namespace galera
+{
+
+// Bounded list of the last contact changes, each change receives a new revision.
+// Clients that missed the change signals use the revision of their last sync to
+// fetch only the contacts changed after that, the oldest changes are discarded when
+// the journal is full and the clients that need them must query all contacts again.
+// The revision carries a random epoch in the high 32 bits, revisions returned by other
+// service instances or before a reset are always rejected.
+class ChangeJournal
+{
+public:
+    enum Operation {
+        Added = 0,
+        Updated,
+        Removed
+    };
+
+    ChangeJournal(int capacity = DefaultCapacity);
+
+    void append(Operation operation, const QSet<QString> &ids);
+    // discard all changes and start a new epoch, clients must query all contacts again
+    void reset();
+
+    // revision of the last change
+    quint64 revision() const;
+    // merge the changes done after 'revision', returns false if the changes are not
+    // available anymore
+    bool changesSince(quint64 revision, QStringList *added, QStringList *updated, QStringList *removed) const;
+
+    static const int DefaultCapacity = 4096;
+
+private:
+    class Change
+    {
+    public:
+        Operation operation;
+        QString id;
+    };
+
+    // ring buffer, m_first is the position of the oldest change
+    QVector<Change> m_changes;
+    int m_first;
+    int m_size;
+    quint32 m_epoch;
+    quint32 m_counter;
+};
+
+} //namespace
+
+#endif
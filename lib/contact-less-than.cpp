@@ -25,13 +25,251 @@
 
 #include <QtCore/QTime>
 #include <QtCore/QDebug>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QVector>
 
 #include <QtContacts/QContactManagerEngine>
+#include <QtContacts/qcontactdetails.h>
+
+#include <algorithm>
 
 using namespace QtContacts;
 
 namespace galera {
 
+ContactSortKey::ContactSortKey(const QContact &contact, const SortClause &sortClause)
+    : m_sortOrders(sortClause.toContactSortOrder())
+{
+    Q_FOREACH(const QContactSortOrder &sortOrder, m_sortOrders) {
+        Field field;
+        field.keyIndex = -1;
+        field.value = contact.detail(sortOrder.detailType()).value(sortOrder.detailField());
+
+        // treat empty strings as null values, the same as QContactManagerEngine::compareContact
+        if (field.value.type() == QVariant::String) {
+            QString value = field.value.toString();
+            field.isBlank = value.isEmpty();
+            if (!field.isBlank) {
+                field.keyIndex = m_keys.size();
+                m_keys << collator(sortOrder.caseSensitivity())->sortKey(value);
+            }
+            field.value = QVariant();
+        } else {
+            field.isBlank = field.value.isNull();
+        }
+        m_fields << field;
+    }
+}
+
+bool ContactSortKey::isValidFor(const SortClause &sortClause) const
+{
+    return (m_sortOrders == sortClause.toContactSortOrder());
+}
+
+int ContactSortKey::compare(const ContactSortKey &other) const
+{
+    return ContactSortComparator::compareGeneric(*this, other, m_sortOrders);
+}
+
+// QCollator is not thread safe, keep one instance for each thread
+QCollator *ContactSortKey::collator(Qt::CaseSensitivity sensitivity)
+{
+    static QThreadStorage<QCollator*> sensitiveCollator;
+    static QThreadStorage<QCollator*> insensitiveCollator;
+
+    QThreadStorage<QCollator*> &storage = (sensitivity == Qt::CaseSensitive ? sensitiveCollator : insensitiveCollator);
+    if (!storage.hasLocalData()) {
+        QCollator *collator = new QCollator(QLocale());
+        collator->setCaseSensitivity(sensitivity);
+        storage.setLocalData(collator);
+    }
+    return storage.localData();
+}
+
+ContactSortComparator::ContactSortComparator(const SortClause &sortClause)
+    : m_sortOrders(sortClause.toContactSortOrder()),
+      m_compare(selectFunction(m_sortOrders))
+{
+}
+
+int ContactSortComparator::compare(const ContactSortKey &keyA, const ContactSortKey &keyB) const
+{
+    return m_compare(keyA, keyB, m_sortOrders);
+}
+
+ContactSortComparator::CompareFunction ContactSortComparator::selectFunction(const QList<QContactSortOrder> &sortOrders)
+{
+    Q_FOREACH(const QContactSortOrder &sortOrder, sortOrders) {
+        if (!sortOrder.isValid() || !isStringField(sortOrder)) {
+            return &ContactSortComparator::compareGeneric;
+        }
+    }
+
+    if (isDefaultSort(sortOrders)) {
+        return &ContactSortComparator::compareDefault;
+    }
+
+    if (sortOrders.size() == 1) {
+        const QContactSortOrder &sortOrder = sortOrders.first();
+        bool blanksFirst = (sortOrder.blankPolicy() == QContactSortOrder::BlanksFirst);
+        if (sortOrder.direction() == Qt::AscendingOrder) {
+            return blanksFirst ? &ContactSortComparator::compareSingleField<Qt::AscendingOrder, QContactSortOrder::BlanksFirst>
+                               : &ContactSortComparator::compareSingleField<Qt::AscendingOrder, QContactSortOrder::BlanksLast>;
+        } else {
+            return blanksFirst ? &ContactSortComparator::compareSingleField<Qt::DescendingOrder, QContactSortOrder::BlanksFirst>
+                               : &ContactSortComparator::compareSingleField<Qt::DescendingOrder, QContactSortOrder::BlanksLast>;
+        }
+    }
+
+    return &ContactSortComparator::compareStrings;
+}
+
+// all fields exposed by SortClause::supportedFields() are strings except BIRTHDAY, PHOTO and IM_PROTOCOL
+bool ContactSortComparator::isStringField(const QContactSortOrder &sortOrder)
+{
+    switch (sortOrder.detailType()) {
+    case QContactDetail::TypeOnlineAccount:
+        return (sortOrder.detailField() != QContactOnlineAccount::FieldProtocol);
+    case QContactDetail::TypeName:
+    case QContactDetail::TypeDisplayLabel:
+    case QContactDetail::TypeNickname:
+    case QContactDetail::TypeOrganization:
+    case QContactDetail::TypeEmailAddress:
+    case QContactDetail::TypePhoneNumber:
+    case QContactDetail::TypeAddress:
+    case QContactDetail::TypeTag:
+    case QContactDetail::TypeUrl:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ContactSortComparator::isDefaultSort(const QList<QContactSortOrder> &sortOrders)
+{
+    if (sortOrders.size() != 2) {
+        return false;
+    }
+
+    const QContactSortOrder &tag = sortOrders.at(0);
+    const QContactSortOrder &label = sortOrders.at(1);
+    return ((tag.detailType() == QContactDetail::TypeTag) &&
+            (tag.detailField() == QContactTag::FieldTag) &&
+            (tag.direction() == Qt::AscendingOrder) &&
+            (tag.blankPolicy() == QContactSortOrder::BlanksLast) &&
+            (label.detailType() == QContactDetail::TypeDisplayLabel) &&
+            (label.detailField() == QContactDisplayLabel::FieldLabel) &&
+            (label.direction() == Qt::AscendingOrder) &&
+            (label.blankPolicy() == QContactSortOrder::BlanksLast));
+}
+
+template<Qt::SortOrder Direction, QContactSortOrder::BlankPolicy Blanks>
+int ContactSortComparator::compareStringField(const ContactSortKey &keyA, const ContactSortKey &keyB, int index)
+{
+    const ContactSortKey::Field &fieldA = keyA.m_fields.at(index);
+    const ContactSortKey::Field &fieldB = keyB.m_fields.at(index);
+    if (fieldA.isBlank || fieldB.isBlank) {
+        if (fieldA.isBlank == fieldB.isBlank) {
+            return 0;
+        }
+        int blankA = (Blanks == QContactSortOrder::BlanksFirst ? -1 : 1);
+        return fieldA.isBlank ? blankA : -blankA;
+    }
+
+    int comparison;
+    if ((fieldA.keyIndex >= 0) && (fieldB.keyIndex >= 0)) {
+        comparison = keyA.m_keys.at(fieldA.keyIndex).compare(keyB.m_keys.at(fieldB.keyIndex));
+    } else {
+        // the detail does not contain a string value, this should not happen for the fields above
+        comparison = QContactManagerEngine::compareVariant(fieldA.value, fieldB.value, Qt::CaseInsensitive);
+    }
+    return (Direction == Qt::AscendingOrder ? comparison : -comparison);
+}
+
+template<Qt::SortOrder Direction, QContactSortOrder::BlankPolicy Blanks>
+int ContactSortComparator::compareSingleField(const ContactSortKey &keyA,
+                                              const ContactSortKey &keyB,
+                                              const QList<QContactSortOrder> &sortOrders)
+{
+    Q_UNUSED(sortOrders);
+    return compareStringField<Direction, Blanks>(keyA, keyB, 0);
+}
+
+int ContactSortComparator::compareDefault(const ContactSortKey &keyA,
+                                          const ContactSortKey &keyB,
+                                          const QList<QContactSortOrder> &sortOrders)
+{
+    Q_UNUSED(sortOrders);
+    // TAG ASC, DISPLAY_LABEL ASC with blanks last
+    int comparison = compareStringField<Qt::AscendingOrder, QContactSortOrder::BlanksLast>(keyA, keyB, 0);
+    if (comparison == 0) {
+        comparison = compareStringField<Qt::AscendingOrder, QContactSortOrder::BlanksLast>(keyA, keyB, 1);
+    }
+    return comparison;
+}
+
+int ContactSortComparator::compareStrings(const ContactSortKey &keyA,
+                                          const ContactSortKey &keyB,
+                                          const QList<QContactSortOrder> &sortOrders)
+{
+    for (int i = 0, iMax = sortOrders.size(); i < iMax; i++) {
+        const QContactSortOrder &sortOrder = sortOrders.at(i);
+        int comparison;
+        if (sortOrder.direction() == Qt::AscendingOrder) {
+            comparison = (sortOrder.blankPolicy() == QContactSortOrder::BlanksFirst ?
+                          compareStringField<Qt::AscendingOrder, QContactSortOrder::BlanksFirst>(keyA, keyB, i) :
+                          compareStringField<Qt::AscendingOrder, QContactSortOrder::BlanksLast>(keyA, keyB, i));
+        } else {
+            comparison = (sortOrder.blankPolicy() == QContactSortOrder::BlanksFirst ?
+                          compareStringField<Qt::DescendingOrder, QContactSortOrder::BlanksFirst>(keyA, keyB, i) :
+                          compareStringField<Qt::DescendingOrder, QContactSortOrder::BlanksLast>(keyA, keyB, i));
+        }
+        if (comparison != 0) {
+            return comparison;
+        }
+    }
+    return 0;
+}
+
+// same semantics as QContactManagerEngine::compareContact
+int ContactSortComparator::compareGeneric(const ContactSortKey &keyA,
+                                          const ContactSortKey &keyB,
+                                          const QList<QContactSortOrder> &sortOrders)
+{
+    for (int i = 0, iMax = qMin(keyA.m_fields.size(), keyB.m_fields.size()); i < iMax; i++) {
+        const QContactSortOrder &sortOrder = sortOrders.at(i);
+        if (!sortOrder.isValid()) {
+            break;
+        }
+
+        const ContactSortKey::Field &fieldA = keyA.m_fields.at(i);
+        const ContactSortKey::Field &fieldB = keyB.m_fields.at(i);
+        if (fieldA.isBlank && fieldB.isBlank) {
+            continue;
+        }
+        if (fieldA.isBlank) {
+            return (sortOrder.blankPolicy() == QContactSortOrder::BlanksFirst ? -1 : 1);
+        }
+        if (fieldB.isBlank) {
+            return (sortOrder.blankPolicy() == QContactSortOrder::BlanksFirst ? 1 : -1);
+        }
+
+        int comparison;
+        if ((fieldA.keyIndex >= 0) && (fieldB.keyIndex >= 0)) {
+            comparison = keyA.m_keys.at(fieldA.keyIndex).compare(keyB.m_keys.at(fieldB.keyIndex));
+        } else {
+            comparison = QContactManagerEngine::compareVariant(fieldA.value,
+                                                               fieldB.value,
+                                                               sortOrder.caseSensitivity());
+        }
+
+        if (comparison != 0) {
+            return (sortOrder.direction() == Qt::AscendingOrder ? comparison : -comparison);
+        }
+    }
+    return 0;
+}
+
 ContactLessThan::ContactLessThan(const galera::SortClause &sortClause)
     : m_sortClause(sortClause)
 {
@@ -45,18 +283,79 @@ bool ContactLessThan::operator()(const QtContacts::QContact &contactA, const QtC
     return (r <= 0);
 }
 
+void ContactLessThan::sort(QList<QContact> *contacts, const SortClause &sortClause, int maxCount)
+{
+    QVector<int> sortedOrder = order(*contacts, sortClause, maxCount);
+
+    QList<QContact> sorted;
+    sorted.reserve(sortedOrder.size());
+    Q_FOREACH(int i, sortedOrder) {
+        sorted << contacts->at(i);
+    }
+    *contacts = sorted;
+}
+
+QVector<int> ContactLessThan::order(const QList<QContact> &contacts, const SortClause &sortClause, int maxCount)
+{
+    if ((maxCount <= 0) || (maxCount > contacts.size())) {
+        maxCount = contacts.size();
+    }
+
+    QVector<int> result;
+    result.reserve(maxCount);
+    if (sortClause.isEmpty() || (contacts.size() < 2)) {
+        for (int i = 0; i < maxCount; i++) {
+            result << i;
+        }
+        return result;
+    }
+
+    QList<ContactSortKey> keys;
+    for (int i = 0; i < contacts.size(); i++) {
+        keys << ContactSortKey(contacts.at(i), sortClause);
+    }
+
+    // equal contacts keep the list order
+    ContactSortComparator comparator(sortClause);
+    auto lessThan = [&keys, &comparator](int a, int b) {
+        int r = comparator.compare(keys.at(a), keys.at(b));
+        return (r < 0) || ((r == 0) && (a < b));
+    };
+
+    if (maxCount < contacts.size()) {
+        // keep the 'maxCount' smallest contacts in a heap, the top is the greatest one
+        for (int i = 0; i < contacts.size(); i++) {
+            if (result.size() < maxCount) {
+                result << i;
+                std::push_heap(result.begin(), result.end(), lessThan);
+            } else if (lessThan(i, result.first())) {
+                std::pop_heap(result.begin(), result.end(), lessThan);
+                result.last() = i;
+                std::push_heap(result.begin(), result.end(), lessThan);
+            }
+        }
+        std::sort_heap(result.begin(), result.end(), lessThan);
+    } else {
+        for (int i = 0; i < contacts.size(); i++) {
+            result << i;
+        }
+        std::sort(result.begin(), result.end(), lessThan);
+    }
+    return result;
+}
+
 ContactEntryLessThan::ContactEntryLessThan(const SortClause &sortClause)
-    : m_sortClause(sortClause)
+    : m_sortClause(sortClause),
+      m_comparator(sortClause)
 {
 
 }
 
 bool ContactEntryLessThan::operator()(ContactEntry *entryA, ContactEntry *entryB)
 {
-    int r = QContactManagerEngine::compareContact(entryA->individual()->contact(),
-                                                  entryB->individual()->contact(),
-                                                  m_sortClause.toContactSortOrder());
-    return (r <= 0);
+    // strict, the tree inserts equal contacts after the existing ones
+    int r = m_comparator.compare(entryA->sortKey(m_sortClause), entryB->sortKey(m_sortClause));
+    return (r < 0);
 }
 
 } // namespace
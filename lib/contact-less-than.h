@@ -23,6 +23,8 @@
 
 #include <QtCore/QString>
 #include <QtCore/QVariant>
+#include <QtCore/QCollator>
+#include <QtCore/QVector>
 
 #include <QtContacts/QContact>
 
@@ -30,6 +32,76 @@ namespace galera {
 
 class ContactEntry;
 
+// Pre-computed values used to sort a contact, string fields are stored as locale
+// aware collation keys. This avoid extract and compare the contact details on each comparison
+class ContactSortKey
+{
+public:
+    ContactSortKey(const QtContacts::QContact &contact, const SortClause &sortClause);
+
+    bool isValidFor(const SortClause &sortClause) const;
+    int compare(const ContactSortKey &other) const;
+
+private:
+    class Field
+    {
+    public:
+        // index on m_keys for string fields or -1
+        int keyIndex;
+        QVariant value;
+        bool isBlank;
+    };
+
+    QList<QtContacts::QContactSortOrder> m_sortOrders;
+    QList<Field> m_fields;
+    QList<QCollatorSortKey> m_keys;
+
+    static QCollator *collator(Qt::CaseSensitivity sensitivity);
+
+    friend class ContactSortComparator;
+};
+
+// Compare two sort keys using a function selected once for the sort clause. The built-in
+// string fields are compared by specialized functions that skip the generic sort order
+// interpretation, with a dedicated path for the default "TAG, DISPLAY_LABEL" sort
+class ContactSortComparator
+{
+public:
+    ContactSortComparator(const SortClause &sortClause);
+
+    int compare(const ContactSortKey &keyA, const ContactSortKey &keyB) const;
+
+private:
+    typedef int (*CompareFunction)(const ContactSortKey &keyA,
+                                   const ContactSortKey &keyB,
+                                   const QList<QtContacts::QContactSortOrder> &sortOrders);
+
+    QList<QtContacts::QContactSortOrder> m_sortOrders;
+    CompareFunction m_compare;
+
+    static CompareFunction selectFunction(const QList<QtContacts::QContactSortOrder> &sortOrders);
+    static bool isStringField(const QtContacts::QContactSortOrder &sortOrder);
+    static bool isDefaultSort(const QList<QtContacts::QContactSortOrder> &sortOrders);
+
+    template<Qt::SortOrder Direction, QtContacts::QContactSortOrder::BlankPolicy Blanks>
+    static int compareStringField(const ContactSortKey &keyA, const ContactSortKey &keyB, int index);
+    template<Qt::SortOrder Direction, QtContacts::QContactSortOrder::BlankPolicy Blanks>
+    static int compareSingleField(const ContactSortKey &keyA,
+                                  const ContactSortKey &keyB,
+                                  const QList<QtContacts::QContactSortOrder> &sortOrders);
+    static int compareDefault(const ContactSortKey &keyA,
+                              const ContactSortKey &keyB,
+                              const QList<QtContacts::QContactSortOrder> &sortOrders);
+    static int compareStrings(const ContactSortKey &keyA,
+                              const ContactSortKey &keyB,
+                              const QList<QtContacts::QContactSortOrder> &sortOrders);
+    static int compareGeneric(const ContactSortKey &keyA,
+                              const ContactSortKey &keyB,
+                              const QList<QtContacts::QContactSortOrder> &sortOrders);
+
+    friend class ContactSortKey;
+};
+
 class ContactLessThan
 {
 public:
@@ -37,6 +109,12 @@ public:
 
     bool operator()(const QtContacts::QContact &contactA, const QtContacts::QContact &contactB);
 
+    // sort the list computing the sort key only once for each contact, if 'maxCount' is
+    // greater than 0 only the first 'maxCount' contacts are kept
+    static void sort(QList<QtContacts::QContact> *contacts, const SortClause &sortClause, int maxCount = 0);
+    // positions of the contacts in the sorted order, same rules as sort()
+    static QVector<int> order(const QList<QtContacts::QContact> &contacts, const SortClause &sortClause, int maxCount = 0);
+
 private:
     SortClause m_sortClause;
 };
@@ -50,6 +128,7 @@ public:
 
 private:
     SortClause m_sortClause;
+    ContactSortComparator m_comparator;
 };
 
 } // namespace
@@ -21,29 +21,101 @@
 #include "qindividual.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 
 #include <QtContacts/QContactSortOrder>
 #include <QtContacts/QContactDisplayLabel>
 #include <QtContacts/QContactTag>
 #include <QtContacts/QContactPhoneNumber>
+#include <QtContacts/QContactEmailAddress>
+#include <QtContacts/QContactName>
+#include <QtContacts/QContactNickname>
+#include <QtContacts/QContactSyncTarget>
 
-#include <phonenumbers/phonenumberutil.h>
-#include <phonenumbers/region_code.h>
+#include <algorithm>
 
 using namespace QtContacts;
 
+namespace
+{
+    // minimum number of entries sorted by each thread at the end of a bulk load
+    const int MinSortChunkSize = 1024;
+}
+
 namespace galera
 {
 
+// strict ordering of entries with valid sort keys, used by the sort threads
+class SortKeyLessThan
+{
+public:
+    SortKeyLessThan(const SortClause &sortClause)
+        : m_sortClause(sortClause), m_comparator(sortClause)
+    {
+    }
+
+    bool operator()(ContactEntry *entryA, ContactEntry *entryB) const
+    {
+        return (m_comparator.compare(entryA->sortKey(m_sortClause), entryB->sortKey(m_sortClause)) < 0);
+    }
+
+private:
+    SortClause m_sortClause;
+    ContactSortComparator m_comparator;
+};
+
+class SortEntriesTask : public QRunnable
+{
+public:
+    SortEntriesTask(ContactEntry **begin, ContactEntry **end, const SortKeyLessThan &lessThan)
+        : m_begin(begin), m_end(end), m_lessThan(lessThan)
+    {
+    }
+
+    void run()
+    {
+        std::stable_sort(m_begin, m_end, m_lessThan);
+    }
+
+private:
+    ContactEntry **m_begin;
+    ContactEntry **m_end;
+    SortKeyLessThan m_lessThan;
+};
+
+class MergeEntriesTask : public QRunnable
+{
+public:
+    MergeEntriesTask(ContactEntry **begin, ContactEntry **middle, ContactEntry **end, const SortKeyLessThan &lessThan)
+        : m_begin(begin), m_middle(middle), m_end(end), m_lessThan(lessThan)
+    {
+    }
+
+    void run()
+    {
+        std::inplace_merge(m_begin, m_middle, m_end, m_lessThan);
+    }
+
+private:
+    ContactEntry **m_begin;
+    ContactEntry **m_middle;
+    ContactEntry **m_end;
+    SortKeyLessThan m_lessThan;
+};
+
 //ContactInfo
 ContactEntry::ContactEntry(QIndividual *individual)
-    : m_individual(individual)
+    : m_individual(individual),
+      m_sortKeyVersion(0)
 {
     Q_ASSERT(individual);
 }
 
 ContactEntry::~ContactEntry()
 {
+    qDeleteAll(m_sortKeys);
     delete m_individual;
 }
 
@@ -52,9 +124,48 @@ QIndividual *ContactEntry::individual() const
     return m_individual;
 }
 
+const ContactSortKey &ContactEntry::sortKey(const SortClause &sortClause)
+{
+    if (m_sortKeyVersion != m_individual->version()) {
+        qDeleteAll(m_sortKeys);
+        m_sortKeys.clear();
+        m_sortKeyVersion = m_individual->version();
+    }
+
+    Q_FOREACH(ContactSortKey *key, m_sortKeys) {
+        if (key->isValidFor(sortClause)) {
+            return *key;
+        }
+    }
+
+    // only the newest key is replaced, the first ones are usually used by the map
+    if (m_sortKeys.size() >= MaxSortKeys) {
+        delete m_sortKeys.takeLast();
+    }
+    m_sortKeys << new ContactSortKey(m_individual->contact(), sortClause);
+    return *m_sortKeys.last();
+}
+
+const ContactSnapshotEntry &ContactEntry::snapshotEntry()
+{
+    if (m_snapshotEntry.id.isEmpty() ||
+        (m_snapshotEntry.version != m_individual->version())) {
+        m_snapshotEntry.id = m_individual->id();
+        m_snapshotEntry.version = m_individual->version();
+        m_snapshotEntry.contact = m_individual->contact();
+        m_snapshotEntry.phoneNumbers = m_individual->phoneNumbers();
+    }
+    // these are not part of the contact version and are cheap to read
+    m_snapshotEntry.deletedAt = m_individual->deletedAt();
+    m_snapshotEntry.visible = m_individual->isVisible();
+    return m_snapshotEntry;
+}
+
 //ContactMap
 ContactsMap::ContactsMap()
-    : m_sortClause(defaultSort())
+    : m_sortClause(defaultSort()),
+      m_lessThan(m_sortClause),
+      m_bulkLoading(false)
 {
 }
 
@@ -74,7 +185,48 @@ QList<ContactEntry *> ContactsMap::valueByPhone(const QString &phone) const
         return values();
     }
 
-    return m_phoneToEntry.values(minimalNumber(phone));
+    uint key = phoneKey(phone);
+    if (key == 0) {
+        return QList<ContactEntry*>();
+    }
+    return m_phoneToEntry.values(key);
+}
+
+QList<ContactEntry *> ContactsMap::lookup(Index index, const QString &value) const
+{
+    switch (index) {
+    case IdIndex:
+        return values(QStringList() << value);
+    case PhoneIndex:
+        return valueByPhone(value);
+    case EmailIndex:
+        return m_emailToEntry.values(emailKey(value));
+    case NameIndex:
+        return m_nameToEntry.values(nameKey(value));
+    case SourceIndex:
+        return m_sourceToEntry.values(value);
+    }
+    return QList<ContactEntry*>();
+}
+
+int ContactsMap::estimate(Index index, const QString &value) const
+{
+    switch (index) {
+    case IdIndex:
+        return m_idToEntry.contains(value) ? 1 : 0;
+    case PhoneIndex:
+    {
+        uint key = phoneKey(value);
+        return (key == 0) ? 0 : m_phoneToEntry.count(key);
+    }
+    case EmailIndex:
+        return m_emailToEntry.count(emailKey(value));
+    case NameIndex:
+        return m_nameToEntry.count(nameKey(value));
+    case SourceIndex:
+        return m_sourceToEntry.count(value);
+    }
+    return size();
 }
 
 QList<ContactEntry *> ContactsMap::values(const QStringList &ids) const
@@ -97,7 +249,7 @@ ContactEntry *ContactsMap::take(FolksIndividual *individual)
 
 ContactEntry *ContactsMap::take(const QString &id)
 {
-    QWriteLocker locker(&m_mutex);
+    m_snapshot.clear();
     ContactEntry *entry = m_idToEntry.take(id);
     removeData(entry, false);
     return entry;
@@ -105,41 +257,32 @@ ContactEntry *ContactsMap::take(const QString &id)
 
 void ContactsMap::remove(const QString &id)
 {
-    QWriteLocker locker(&m_mutex);
+    m_snapshot.clear();
     ContactEntry *entry = m_idToEntry.take(id);
     removeData(entry, true);
 }
 
 void ContactsMap::insert(ContactEntry *entry)
 {
-    QWriteLocker locker(&m_mutex);
+    m_snapshot.clear();
     insertData(entry);
 }
 
 void ContactsMap::updatePosition(ContactEntry *entry)
 {
-    QWriteLocker locker(&m_mutex);
-    if (!m_sortClause.isEmpty()) {
-        int oldPos = m_contacts.indexOf(entry);
-
-        ContactEntryLessThan lessThan(m_sortClause);
-        QList<ContactEntry*>::iterator it(std::upper_bound(m_contacts.begin(), m_contacts.end(), entry, lessThan));
-
-        if (it != m_contacts.end()) {
-            int newPos = std::distance(m_contacts.begin(), it);
-            if (oldPos != newPos) {
-                m_contacts.move(oldPos, newPos);
-            }
-        } else if (oldPos != (m_contacts.size() - 1)) {
-            m_contacts.move(oldPos, m_contacts.size() -1);
-        }
+    m_snapshot.clear();
+    if (m_bulkLoading) {
+        // the entry will be sorted and indexed at the end of the load
+        return;
     }
 
-    // update phone number map
-    Q_FOREACH(const QString &key, m_phoneToEntry.keys(entry)) {
-        m_phoneToEntry.remove(key, entry);
+    if (!m_sortClause.isEmpty()) {
+        m_contacts.update(entry, m_lessThan);
     }
-    insertData(entry->individual()->contact().details<QContactPhoneNumber>(), entry);
+
+    // update the detail indexes
+    removeIndexes(entry);
+    insertIndexes(entry);
 }
 
 int ContactsMap::size() const
@@ -149,33 +292,56 @@ int ContactsMap::size() const
 
 void ContactsMap::clear()
 {
-    QWriteLocker locker(&m_mutex);
+    m_snapshot.clear();
     QList<ContactEntry*> entries = m_idToEntry.values();
     m_idToEntry.clear();
     m_phoneToEntry.clear();
+    m_emailToEntry.clear();
+    m_nameToEntry.clear();
+    m_sourceToEntry.clear();
     m_contacts.clear();
     qDeleteAll(entries);
 }
 
-void ContactsMap::lockForRead()
+QSharedPointer<const ContactsSnapshot> ContactsMap::snapshot()
 {
-    m_mutex.lockForRead();
+    if (m_snapshot.isNull()) {
+        ContactsSnapshot *snapshot = new ContactsSnapshot;
+        snapshot->sortClause = m_sortClause;
+        snapshot->entries.reserve(m_contacts.size());
+        // the unchanged entries share the data of the previous snapshot
+        Q_FOREACH(ContactEntry *entry, m_contacts.values()) {
+            snapshot->entries << entry->snapshotEntry();
+        }
+        m_snapshot = QSharedPointer<const ContactsSnapshot>(snapshot);
+    }
+    return m_snapshot;
 }
 
-void ContactsMap::unlock()
+QList<ContactEntry*> ContactsMap::values() const
 {
-    m_mutex.unlock();
+    return m_contacts.values();
 }
 
-QList<ContactEntry*> ContactsMap::values() const
+QList<ContactEntry*> ContactsMap::values(int pos, int length) const
 {
-    return m_contacts;
+    return m_contacts.mid(pos, length);
+}
+
+ContactEntry *ContactsMap::at(int pos) const
+{
+    return m_contacts.at(pos);
+}
+
+int ContactsMap::indexOf(ContactEntry *entry) const
+{
+    return m_contacts.indexOf(entry);
 }
 
 QList<QContact> ContactsMap::contacts() const
 {
     QList<QContact> result;
-    Q_FOREACH(ContactEntry *e, m_contacts) {
+    Q_FOREACH(ContactEntry *e, m_contacts.values()) {
         result << e->individual()->contact();
     }
     return result;
@@ -189,10 +355,13 @@ QStringList ContactsMap::keys() const
 void ContactsMap::sertSort(const SortClause &clause)
 {
     if (clause.toContactSortOrder() != m_sortClause.toContactSortOrder()) {
+        m_snapshot.clear();
         m_sortClause = clause;
-        if (!m_sortClause.isEmpty()) {
-            ContactEntryLessThan lessThan(m_sortClause);
-            qSort(m_contacts.begin(), m_contacts.end(), lessThan);
+        m_lessThan = ContactEntryLessThan(m_sortClause);
+        if (!m_sortClause.isEmpty() && !m_bulkLoading) {
+            QList<ContactEntry*> sorted = m_contacts.values();
+            std::stable_sort(sorted.begin(), sorted.end(), m_lessThan);
+            m_contacts.rebuild(sorted);
         }
     }
 }
@@ -202,6 +371,74 @@ SortClause ContactsMap::sort() const
     return m_sortClause;
 }
 
+void ContactsMap::beginBulkLoad()
+{
+    m_bulkLoading = true;
+}
+
+void ContactsMap::endBulkLoad()
+{
+    if (!m_bulkLoading) {
+        return;
+    }
+
+    m_bulkLoading = false;
+    m_snapshot.clear();
+
+    QVector<ContactEntry*> entries = m_contacts.values().toVector();
+    m_phoneToEntry.reserve(entries.size());
+    m_emailToEntry.reserve(entries.size());
+    m_nameToEntry.reserve(entries.size());
+    m_sourceToEntry.reserve(entries.size());
+
+    // the sort keys are created here, the sort threads only read them
+    const bool sort = !m_sortClause.isEmpty();
+    Q_FOREACH(ContactEntry *entry, entries) {
+        insertIndexes(entry);
+        if (sort) {
+            entry->sortKey(m_sortClause);
+        }
+    }
+
+    if (!sort || entries.size() < 2) {
+        return;
+    }
+
+    // sort chunks in parallel and merge them, the sort and merge are stable so equal
+    // contacts keep the arrival order like the tree insert after the load
+    const int chunks = qMax(1, qMin(entries.size() / MinSortChunkSize, QThread::idealThreadCount()));
+    QVector<int> bounds;
+    for (int i = 0; i <= chunks; i++) {
+        bounds << (entries.size() * i / chunks);
+    }
+
+    SortKeyLessThan lessThan(m_sortClause);
+    ContactEntry **data = entries.data();
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+    for (int i = 0; i < chunks; i++) {
+        pool.start(new SortEntriesTask(data + bounds[i], data + bounds[i + 1], lessThan));
+    }
+    pool.waitForDone();
+
+    for (int width = 1; width < chunks; width *= 2) {
+        for (int i = 0; (i + width) < chunks; i += (2 * width)) {
+            pool.start(new MergeEntriesTask(data + bounds[i],
+                                            data + bounds[i + width],
+                                            data + bounds[qMin(i + (2 * width), chunks)],
+                                            lessThan));
+        }
+        pool.waitForDone();
+    }
+
+    m_contacts.rebuild(entries.toList());
+}
+
+bool ContactsMap::isBulkLoading() const
+{
+    return m_bulkLoading;
+}
+
 SortClause ContactsMap::defaultSort()
 {
     static SortClause clause("");
@@ -262,10 +499,8 @@ ContactEntry *ContactsMap::value(FolksIndividual *individual) const
 void ContactsMap::removeData(ContactEntry *entry, bool del)
 {
     if (entry) {
-        Q_FOREACH(const QString &key,  m_phoneToEntry.keys(entry)) {
-            m_phoneToEntry.remove(key, entry);
-        }
-        m_contacts.removeOne(entry);
+        removeIndexes(entry);
+        m_contacts.remove(entry);
         if (del) {
             delete entry;
         }
@@ -283,41 +518,152 @@ void ContactsMap::insertData(ContactEntry *entry)
         m_idToEntry.insert(folks_individual_get_id(fIndividual), entry);
 
         // fill contact list
-        if (!m_sortClause.isEmpty()) {
-            ContactEntryLessThan lessThan(m_sortClause);
-            QList<ContactEntry*>::iterator it(std::upper_bound(m_contacts.begin(), m_contacts.end(), entry, lessThan));
-            m_contacts.insert(it, entry);
+        if (!m_sortClause.isEmpty() && !m_bulkLoading) {
+            m_contacts.insert(entry, m_lessThan);
         } else {
             m_contacts.append(entry);
         }
 
-        // fill phone map
-        insertData(entry->individual()->contact().details<QContactPhoneNumber>(), entry);
+        // fill detail indexes
+        if (!m_bulkLoading) {
+            insertIndexes(entry);
+        }
     }
 }
 
-void ContactsMap::insertData(const QList<QContactPhoneNumber> &numbers, ContactEntry *entry)
+void ContactsMap::insertIndexes(ContactEntry *entry)
 {
-    Q_FOREACH(const QContactPhoneNumber &phone, numbers) {
-        QString mNumber = minimalNumber(phone.number());
-        if (!mNumber.isEmpty()) {
-            m_phoneToEntry.insert(mNumber, entry);
+    const QContact contact = entry->individual()->contact();
+
+    // phone numbers are normalized only once by the individual
+    Q_FOREACH(const ParsedPhoneNumber &phone, entry->individual()->phoneNumbers()) {
+        uint key = normalizedPhoneKey(phone.normalized());
+        if ((key != 0) && !entry->m_phoneKeys.contains(key)) {
+            entry->m_phoneKeys << key;
+            m_phoneToEntry.insert(key, entry);
+        }
+    }
+
+    Q_FOREACH(const QContactEmailAddress &email, contact.details<QContactEmailAddress>()) {
+        QString key = emailKey(email.emailAddress());
+        if (!key.isEmpty() && !entry->m_emailKeys.contains(key)) {
+            entry->m_emailKeys << key;
+            m_emailToEntry.insert(key, entry);
+        }
+    }
+
+    entry->m_nameKeys = nameKeys(contact);
+    Q_FOREACH(const QChar &key, entry->m_nameKeys) {
+        m_nameToEntry.insert(key, entry);
+    }
+
+    Q_FOREACH(const QContactSyncTarget &target, contact.details<QContactSyncTarget>()) {
+        QString key = target.value(QContactSyncTarget::FieldSyncTarget + 1).toString();
+        if (!key.isEmpty() && !entry->m_sourceKeys.contains(key)) {
+            entry->m_sourceKeys << key;
+            m_sourceToEntry.insert(key, entry);
         }
     }
 }
 
-QString ContactsMap::minimalNumber(const QString &phone) const
+void ContactsMap::removeIndexes(ContactEntry *entry)
 {
-    static i18n::phonenumbers::PhoneNumberUtil *phonenumberUtil = i18n::phonenumbers::PhoneNumberUtil::GetInstance();
+    Q_FOREACH(uint key, entry->m_phoneKeys) {
+        m_phoneToEntry.remove(key, entry);
+    }
+    entry->m_phoneKeys.clear();
+
+    Q_FOREACH(const QString &key, entry->m_emailKeys) {
+        m_emailToEntry.remove(key, entry);
+    }
+    entry->m_emailKeys.clear();
+
+    Q_FOREACH(const QChar &key, entry->m_nameKeys) {
+        m_nameToEntry.remove(key, entry);
+    }
+    entry->m_nameKeys.clear();
+
+    Q_FOREACH(const QString &key, entry->m_sourceKeys) {
+        m_sourceToEntry.remove(key, entry);
+    }
+    entry->m_sourceKeys.clear();
+}
+
+// fields indexed by the first letter, see insertIndexes()
+bool ContactsMap::isNameField(QContactDetail::DetailType type, int field)
+{
+    switch (type) {
+    case QContactDetail::TypeDisplayLabel:
+        return (field == QContactDisplayLabel::FieldLabel);
+    case QContactDetail::TypeNickname:
+        return (field == QContactNickname::FieldNickname);
+    case QContactDetail::TypeName:
+        return ((field == QContactName::FieldFirstName) ||
+                (field == QContactName::FieldMiddleName) ||
+                (field == QContactName::FieldLastName));
+    default:
+        return false;
+    }
+}
+
+uint ContactsMap::phoneKey(const QString &phone)
+{
+    return normalizedPhoneKey(ParsedPhoneNumber::normalize(phone));
+}
+
+// Encode the minimal number (last 7 diallable chars) as a integer, each char uses a
+// base 14 digit starting from 1, this way numbers with different length never collide.
+// Returns 0 if the phone does not contain any diallable char.
+uint ContactsMap::normalizedPhoneKey(const QString &normalizedPhone)
+{
+    static const QString diallableChars("0123456789+*#");
+
+    uint key = 0;
+    Q_FOREACH(const QChar &c, normalizedPhone.right(7)) {
+        int code = diallableChars.indexOf(c);
+        if (code < 0) {
+            code = diallableChars.size();
+        }
+        key = (key * 14) + code + 1;
+    }
+    return key;
+}
 
-    std::string stdPreprocessedPhone(phone.toStdString());
-    phonenumberUtil->NormalizeDiallableCharsOnly(&stdPreprocessedPhone);
+QString ContactsMap::emailKey(const QString &email)
+{
+    return email.trimmed().toLower();
+}
 
-    if (stdPreprocessedPhone.length() <= 7) {
-        return QString::fromStdString(stdPreprocessedPhone);
+QVector<QChar> ContactsMap::nameKeys(const QContact &contact)
+{
+    // aggregated contacts can have more than one detail of each type, the filter
+    // matches any of them
+    QStringList names;
+    Q_FOREACH(const QContactDisplayLabel &label, contact.details<QContactDisplayLabel>()) {
+        names << label.label();
+    }
+    Q_FOREACH(const QContactNickname &nickname, contact.details<QContactNickname>()) {
+        names << nickname.nickname();
+    }
+    Q_FOREACH(const QContactName &name, contact.details<QContactName>()) {
+        names << name.firstName()
+              << name.middleName()
+              << name.lastName();
     }
 
-    return QString::fromStdString(stdPreprocessedPhone).right(7);
+    QVector<QChar> keys;
+    Q_FOREACH(const QString &n, names) {
+        QChar key = nameKey(n);
+        if (!key.isNull() && !keys.contains(key)) {
+            keys << key;
+        }
+    }
+    return keys;
+}
+
+QChar ContactsMap::nameKey(const QString &name)
+{
+    return name.isEmpty() ? QChar() : name.at(0).toCaseFolded();
 }
 
 } //namespace
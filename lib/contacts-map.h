@@ -19,13 +19,21 @@
 #ifndef __GALERA_CONTACTS_MAP_PRIV_H__
 #define __GALERA_CONTACTS_MAP_PRIV_H__
 
+#include "contacts-tree.h"
+#include "contact-less-than.h"
+
 #include "common/sort-clause.h"
+#include "common/parsed-phone-number.h"
 
 #include <QtCore/QString>
 #include <QtCore/QHash>
-#include <QtCore/QReadWriteLock>
+#include <QtCore/QDateTime>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+#include <QtCore/QStringList>
 
-#include <QtContacts/QContactPhoneNumber>
+#include <QtContacts/QContact>
+#include <QtContacts/QContactDetail>
 
 #include <folks/folks.h>
 #include <glib.h>
@@ -35,6 +43,20 @@ namespace galera
 {
 
 class QIndividual;
+class ContactSortKey;
+
+// Copy of the contact data used by the queries, it does not reference the QIndividual
+// this way it stays valid after the contact be removed from the map
+class ContactSnapshotEntry
+{
+public:
+    QString id;
+    uint version;
+    QtContacts::QContact contact;
+    QDateTime deletedAt;
+    bool visible;
+    QList<ParsedPhoneNumber> phoneNumbers;
+};
 
 class ContactEntry
 {
@@ -43,18 +65,55 @@ public:
     ~ContactEntry();
 
     QIndividual *individual() const;
+    // sort key for the current contact version, it will be re-created if the contact changes.
+    // The keys of a few sort clauses are kept, the views sorted differently from the map do
+    // not replace the key used by the map
+    const ContactSortKey &sortKey(const SortClause &sortClause);
+
+    static const int MaxSortKeys = 4;
+
+    // snapshot data of the contact, the contact details are only copied again if the
+    // contact changed after the last snapshot
+    const ContactSnapshotEntry &snapshotEntry();
 
 private:
     ContactEntry();
     ContactEntry(const ContactEntry &other);
 
     QIndividual *m_individual;
+    // keys of the different sort clauses in creation order
+    QList<ContactSortKey*> m_sortKeys;
+    uint m_sortKeyVersion;
+    ContactSnapshotEntry m_snapshotEntry;
+    // keys used by this entry on the phone, email, name and source indexes
+    QVector<uint> m_phoneKeys;
+    QStringList m_emailKeys;
+    QVector<QChar> m_nameKeys;
+    QStringList m_sourceKeys;
+
+    friend class ContactsMap;
 };
 
+// Immutable state of the contacts map, the entries are in the same order as the map
+class ContactsSnapshot
+{
+public:
+    QVector<ContactSnapshotEntry> entries;
+    SortClause sortClause;
+};
 
 class ContactsMap
 {
 public:
+    enum Index {
+        IdIndex = 0,
+        PhoneIndex,
+        EmailIndex,
+        // first letter of the contact names
+        NameIndex,
+        SourceIndex
+    };
+
     ContactsMap();
     ~ContactsMap();
 
@@ -67,6 +126,10 @@ public:
     ContactEntry *value(const QString &id) const;
     QList<ContactEntry*> valueByPhone(const QString &phone) const;
     QList<ContactEntry*> values(const QStringList &ids) const;
+    // entries that may match the value on the index, the result can contain false positives
+    QList<ContactEntry*> lookup(Index index, const QString &value) const;
+    // number of entries returned by lookup() without building the list
+    int estimate(Index index, const QString &value) const;
 
     ContactEntry *take(FolksIndividual *individual);
     ContactEntry *take(const QString &id);
@@ -76,29 +139,54 @@ public:
     void updatePosition(ContactEntry *entry);
     int size() const;
     void clear();
-    void lockForRead();
-    void unlock();
+    // the current map state, the snapshot is only re-created after the map changes
+    // and can be used by any thread without lock the map
+    QSharedPointer<const ContactsSnapshot> snapshot();
     QList<ContactEntry*> values() const;
+    QList<ContactEntry*> values(int pos, int length) const;
+    ContactEntry *at(int pos) const;
+    int indexOf(ContactEntry *entry) const;
     QList<QtContacts::QContact> contacts() const;
     QStringList keys() const;
 
     void sertSort(const SortClause &clause);
     SortClause sort() const;
 
+    // while loading the entries are appended without sort and the detail indexes are not
+    // filled, all entries are indexed and sorted once when the load ends
+    void beginBulkLoad();
+    void endBulkLoad();
+    bool isBulkLoading() const;
+
     static SortClause defaultSort();
+    static bool isNameField(QtContacts::QContactDetail::DetailType type, int field);
+    // keys of the name index for all name fields of the contact
+    static QVector<QChar> nameKeys(const QtContacts::QContact &contact);
 
 private:
     QHash<QString, ContactEntry*> m_idToEntry;
-    QMultiMap<QString, ContactEntry*> m_phoneToEntry;
+    QMultiHash<uint, ContactEntry*> m_phoneToEntry;
+    QMultiHash<QString, ContactEntry*> m_emailToEntry;
+    QMultiHash<QChar, ContactEntry*> m_nameToEntry;
+    QMultiHash<QString, ContactEntry*> m_sourceToEntry;
     // sorted contacts
-    QList<ContactEntry*> m_contacts;
+    ContactsTree m_contacts;
     SortClause m_sortClause;
-    QReadWriteLock m_mutex;
+    // comparator selected for the current sort clause
+    ContactEntryLessThan m_lessThan;
+    // last published snapshot, null if the map changed after that
+    QSharedPointer<const ContactsSnapshot> m_snapshot;
+    bool m_bulkLoading;
 
     void removeData(ContactEntry *entry, bool del);
     void insertData(ContactEntry *entry);
-    void insertData(const QList<QtContacts::QContactPhoneNumber> &numbers, ContactEntry *entry);
-    QString minimalNumber(const QString &phone) const;
+    void insertIndexes(ContactEntry *entry);
+    void removeIndexes(ContactEntry *entry);
+
+    static uint phoneKey(const QString &phone);
+    static uint normalizedPhoneKey(const QString &normalizedPhone);
+    static QString emailKey(const QString &email);
+    static QChar nameKey(const QString &name);
 };
 
 } //namespace
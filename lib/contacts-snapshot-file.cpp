@@ -0,0 +1,214 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contacts-snapshot-file.h"
+#include "contacts-map.h"
+
+#include "config.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThreadPool>
+
+#include <QtContacts/QContact>
+
+using namespace QtContacts;
+
+namespace
+{
+    // "GSNP"
+    const quint32 SnapshotMagic = 0x47534e50;
+    // must be increased if the entry format changes
+    const quint32 SnapshotVersion = 2;
+}
+
+namespace galera
+{
+
+class SaveSnapshotTask : public QRunnable
+{
+public:
+    SaveSnapshotTask(const QString &path, const QSharedPointer<const ContactsSnapshot> &snapshot)
+        : m_path(path),
+          m_snapshot(snapshot)
+    {
+    }
+
+    void run()
+    {
+        ContactsSnapshotFile::save(m_path, *m_snapshot);
+    }
+
+private:
+    QString m_path;
+    QSharedPointer<const ContactsSnapshot> m_snapshot;
+};
+
+QString ContactsSnapshotFile::path()
+{
+    if (qEnvironmentVariableIsSet(ADDRESS_BOOK_SNAPSHOT_FILE)) {
+        // a empty value disables the snapshot
+        return QString::fromLocal8Bit(qgetenv(ADDRESS_BOOK_SNAPSHOT_FILE));
+    }
+
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+           QStringLiteral("/address-book-service/contacts.snapshot");
+}
+
+bool ContactsSnapshotFile::save(const QString &path, const ContactsSnapshot &snapshot)
+{
+    // the file contains all contacts, only the user can read it
+    const QString dir = QFileInfo(path).absolutePath();
+    if (!QDir(dir).exists()) {
+        QDir().mkpath(dir);
+        QFile::setPermissions(dir, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Fail to open the contacts snapshot" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << SnapshotMagic << SnapshotVersion;
+    stream << snapshot.sortClause.toString();
+    stream << quint32(snapshot.entries.size());
+    Q_FOREACH(const ContactSnapshotEntry &entry, snapshot.entries) {
+        QStringList phoneNumbers;
+        Q_FOREACH(const ParsedPhoneNumber &phone, entry.phoneNumbers) {
+            phoneNumbers << phone.number();
+        }
+        stream << entry.id << entry.visible << entry.deletedAt << phoneNumbers << entry.contact;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Fail to write the contacts snapshot" << path;
+        file.cancelWriting();
+        return false;
+    }
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    return file.commit();
+}
+
+void ContactsSnapshotFile::saveAsync(const QString &path, const QSharedPointer<const ContactsSnapshot> &snapshot)
+{
+    QThreadPool::globalInstance()->start(new SaveSnapshotTask(path, snapshot));
+}
+
+QSharedPointer<const ContactsSnapshot> ContactsSnapshotFile::load(const QString &path)
+{
+    QFile file(path);
+    if (path.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return QSharedPointer<const ContactsSnapshot>();
+    }
+
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        qWarning() << "Fail to map the contacts snapshot" << path;
+        return QSharedPointer<const ContactsSnapshot>();
+    }
+
+    // read the mapped memory directly, the values are copied out before unmap
+    QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char*>(data), file.size());
+    QDataStream stream(raw);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString sortClause;
+    quint32 count = 0;
+    stream >> magic >> version;
+    if ((magic != SnapshotMagic) || (version != SnapshotVersion)) {
+        qWarning() << "Ignoring contacts snapshot with invalid version" << path;
+        file.unmap(data);
+        return QSharedPointer<const ContactsSnapshot>();
+    }
+    stream >> sortClause >> count;
+
+    ContactsSnapshot *snapshot = new ContactsSnapshot;
+    snapshot->sortClause = SortClause(sortClause);
+    snapshot->entries.reserve(count);
+    for (quint32 i = 0; (i < count) && (stream.status() == QDataStream::Ok); i++) {
+        ContactSnapshotEntry entry;
+        QStringList phoneNumbers;
+        stream >> entry.id >> entry.visible >> entry.deletedAt >> phoneNumbers >> entry.contact;
+        entry.version = 0;
+        Q_FOREACH(const QString &phone, phoneNumbers) {
+            entry.phoneNumbers << ParsedPhoneNumber(phone);
+        }
+        snapshot->entries << entry;
+    }
+    bool valid = (stream.status() == QDataStream::Ok) && (quint32(snapshot->entries.size()) == count);
+    raw.clear();
+    file.unmap(data);
+
+    if (!valid) {
+        qWarning() << "Ignoring corrupted contacts snapshot" << path;
+        delete snapshot;
+        return QSharedPointer<const ContactsSnapshot>();
+    }
+    return QSharedPointer<const ContactsSnapshot>(snapshot);
+}
+
+ContactsSnapshotLoader::ContactsSnapshotLoader(const QString &path, QObject *receiver, const char *member)
+    : m_path(path),
+      m_receiver(receiver),
+      m_member(member),
+      m_started(false)
+{
+    setAutoDelete(false);
+}
+
+void ContactsSnapshotLoader::start()
+{
+    if (!m_started) {
+        m_started = true;
+        QThreadPool::globalInstance()->start(this);
+    }
+}
+
+void ContactsSnapshotLoader::wait()
+{
+    if (m_started) {
+        m_done.acquire();
+        m_started = false;
+    }
+}
+
+QSharedPointer<const ContactsSnapshot> ContactsSnapshotLoader::result() const
+{
+    return m_result;
+}
+
+void ContactsSnapshotLoader::run()
+{
+    m_result = ContactsSnapshotFile::load(m_path);
+    // the queued call is discarded if the receiver is destroyed after wait()
+    QMetaObject::invokeMethod(m_receiver, m_member.constData(), Qt::QueuedConnection);
+    m_done.release();
+}
+
+} //namespace
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_CONTACTS_SNAPSHOT_FILE_H__
+#define __GALERA_CONTACTS_SNAPSHOT_FILE_H__
+
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+
+namespace galera
+{
+
+class ContactsSnapshot;
+
+// Contacts map snapshot saved on disk by the running service. The next service instance
+// loads the file in a separated thread at start and uses it to answer read-only queries
+// until folks is ready.
+//
+// The file contains a versioned header with the map sort clause followed by the entries
+// in the map order, each entry has the contact id, visibility, deletion date, phone
+// numbers and the contact serialized with QDataStream, this way no vCard is parsed to
+// load the file. The file is only readable by the user, it contains all contacts.
+class ContactsSnapshotFile
+{
+public:
+    // file used by the service, empty if the snapshot is disabled
+    static QString path();
+
+    static bool save(const QString &path, const ContactsSnapshot &snapshot);
+    // save the snapshot in a separated thread
+    static void saveAsync(const QString &path, const QSharedPointer<const ContactsSnapshot> &snapshot);
+    // returns a null pointer if the file does not exist or is not valid
+    static QSharedPointer<const ContactsSnapshot> load(const QString &path);
+};
+
+// Load the snapshot file on the global thread pool, the 'member' slot of 'receiver' is
+// called on the receiver thread when the result is ready
+class ContactsSnapshotLoader : public QRunnable
+{
+public:
+    ContactsSnapshotLoader(const QString &path, QObject *receiver, const char *member);
+
+    void start();
+    // wait the load to finish, must be called before destroy a started loader
+    void wait();
+    // null if the file does not exist or is not valid
+    QSharedPointer<const ContactsSnapshot> result() const;
+
+protected:
+    void run();
+
+private:
+    QString m_path;
+    QObject *m_receiver;
+    QByteArray m_member;
+    QSharedPointer<const ContactsSnapshot> m_result;
+    QSemaphore m_done;
+    bool m_started;
+};
+
+} //namespace
+
+#endif
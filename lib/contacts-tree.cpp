@@ -0,0 +1,350 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contacts-tree.h"
+#include "contact-less-than.h"
+
+#include <QtCore/QStack>
+
+namespace galera
+{
+
+ContactsTree::ContactsTree()
+    : m_root(0),
+      m_seed(2463534242u)
+{
+}
+
+ContactsTree::~ContactsTree()
+{
+    clear();
+}
+
+void ContactsTree::insert(ContactEntry *entry, ContactEntryLessThan &lessThan)
+{
+    Q_ASSERT(!m_nodes.contains(entry));
+    int pos = upperBound(entry, lessThan);
+    insertAt(createNode(entry), pos);
+}
+
+void ContactsTree::append(ContactEntry *entry)
+{
+    Q_ASSERT(!m_nodes.contains(entry));
+    insertAt(createNode(entry), size());
+}
+
+bool ContactsTree::remove(ContactEntry *entry)
+{
+    Node *node = m_nodes.take(entry);
+    if (node) {
+        detach(node);
+        delete node;
+        return true;
+    }
+    return false;
+}
+
+int ContactsTree::update(ContactEntry *entry, ContactEntryLessThan &lessThan)
+{
+    Node *node = m_nodes.value(entry, 0);
+    if (!node) {
+        return -1;
+    }
+
+    // take the node out of the tree before look for its new position,
+    // otherwise the entry would be compared with itself
+    detach(node);
+    int pos = upperBound(entry, lessThan);
+    insertAt(node, pos);
+    return pos;
+}
+
+void ContactsTree::rebuild(const QList<ContactEntry*> &sorted)
+{
+    clear();
+
+    // build the treap in linear time: keep the right spine of the tree in a stack
+    // and rotate the nodes with lower priority to the left of the new node
+    QStack<Node*> spine;
+    Q_FOREACH(ContactEntry *entry, sorted) {
+        Node *node = createNode(entry);
+        Node *last = 0;
+        while (!spine.isEmpty() && (spine.top()->priority < node->priority)) {
+            last = spine.pop();
+            updateNode(last);
+        }
+        node->left = last;
+        if (!spine.isEmpty()) {
+            spine.top()->right = node;
+        }
+        spine.push(node);
+    }
+
+    while (!spine.isEmpty()) {
+        m_root = spine.pop();
+        updateNode(m_root);
+    }
+
+    if (m_root) {
+        m_root->parent = 0;
+    }
+}
+
+void ContactsTree::clear()
+{
+    destroy(m_root);
+    m_root = 0;
+    m_nodes.clear();
+}
+
+bool ContactsTree::contains(ContactEntry *entry) const
+{
+    return m_nodes.contains(entry);
+}
+
+int ContactsTree::indexOf(ContactEntry *entry) const
+{
+    Node *node = m_nodes.value(entry, 0);
+    if (!node) {
+        return -1;
+    }
+
+    int pos = nodeSize(node->left);
+    while (node->parent) {
+        if (node == node->parent->right) {
+            pos += nodeSize(node->parent->left) + 1;
+        }
+        node = node->parent;
+    }
+    return pos;
+}
+
+ContactEntry *ContactsTree::at(int index) const
+{
+    Node *node = select(m_root, index);
+    return node ? node->entry : 0;
+}
+
+int ContactsTree::size() const
+{
+    return nodeSize(m_root);
+}
+
+QList<ContactEntry*> ContactsTree::values() const
+{
+    return mid(0);
+}
+
+QList<ContactEntry*> ContactsTree::mid(int pos, int length) const
+{
+    QList<ContactEntry*> result;
+    if (pos < 0) {
+        pos = 0;
+    }
+
+    int count = size() - pos;
+    if ((length >= 0) && (length < count)) {
+        count = length;
+    }
+
+    if (count <= 0) {
+        return result;
+    }
+
+    result.reserve(count);
+    for (Node *node = select(m_root, pos); node && (count > 0); node = next(node), count--) {
+        result << node->entry;
+    }
+    return result;
+}
+
+ContactsTree::Node *ContactsTree::createNode(ContactEntry *entry)
+{
+    Node *node = new Node;
+    node->entry = entry;
+    node->left = 0;
+    node->right = 0;
+    node->parent = 0;
+    node->size = 1;
+    node->priority = nextPriority();
+    m_nodes.insert(entry, node);
+    return node;
+}
+
+uint ContactsTree::nextPriority()
+{
+    // xorshift32, we only need a cheap and well distributed sequence
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+int ContactsTree::upperBound(ContactEntry *entry, ContactEntryLessThan &lessThan) const
+{
+    int pos = 0;
+    Node *node = m_root;
+    while (node) {
+        if (lessThan(entry, node->entry)) {
+            node = node->left;
+        } else {
+            pos += nodeSize(node->left) + 1;
+            node = node->right;
+        }
+    }
+    return pos;
+}
+
+void ContactsTree::insertAt(Node *node, int pos)
+{
+    Node *left = 0;
+    Node *right = 0;
+
+    node->left = node->right = node->parent = 0;
+    node->size = 1;
+
+    split(m_root, pos, &left, &right);
+    m_root = merge(merge(left, node), right);
+    m_root->parent = 0;
+}
+
+void ContactsTree::detach(Node *node)
+{
+    Node *parent = node->parent;
+    Node *child = merge(node->left, node->right);
+
+    if (!parent) {
+        m_root = child;
+        if (child) {
+            child->parent = 0;
+        }
+    } else {
+        if (parent->left == node) {
+            parent->left = child;
+        } else {
+            parent->right = child;
+        }
+
+        // fix the subtree sizes until the root
+        for (Node *n = parent; n; n = n->parent) {
+            updateNode(n);
+        }
+    }
+
+    node->left = node->right = node->parent = 0;
+    node->size = 1;
+}
+
+int ContactsTree::nodeSize(Node *node)
+{
+    return node ? node->size : 0;
+}
+
+void ContactsTree::updateNode(Node *node)
+{
+    node->size = nodeSize(node->left) + nodeSize(node->right) + 1;
+    if (node->left) {
+        node->left->parent = node;
+    }
+    if (node->right) {
+        node->right->parent = node;
+    }
+}
+
+// split the tree in two: 'left' will receive the first 'pos' nodes and 'right' the remaining ones
+void ContactsTree::split(Node *node, int pos, Node **left, Node **right)
+{
+    if (!node) {
+        *left = *right = 0;
+        return;
+    }
+
+    if (nodeSize(node->left) >= pos) {
+        split(node->left, pos, left, &node->left);
+        *right = node;
+    } else {
+        split(node->right, pos - nodeSize(node->left) - 1, &node->right, right);
+        *left = node;
+    }
+    updateNode(node);
+    node->parent = 0;
+}
+
+// merge two trees, all nodes in 'left' must come before the nodes in 'right'
+ContactsTree::Node *ContactsTree::merge(Node *left, Node *right)
+{
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+
+    if (left->priority > right->priority) {
+        left->right = merge(left->right, right);
+        updateNode(left);
+        return left;
+    } else {
+        right->left = merge(left, right->left);
+        updateNode(right);
+        return right;
+    }
+}
+
+ContactsTree::Node *ContactsTree::select(Node *node, int index)
+{
+    while (node) {
+        int leftSize = nodeSize(node->left);
+        if (index < leftSize) {
+            node = node->left;
+        } else if (index == leftSize) {
+            return node;
+        } else {
+            index -= leftSize + 1;
+            node = node->right;
+        }
+    }
+    return 0;
+}
+
+ContactsTree::Node *ContactsTree::next(Node *node)
+{
+    if (node->right) {
+        node = node->right;
+        while (node->left) {
+            node = node->left;
+        }
+        return node;
+    }
+
+    while (node->parent && (node->parent->right == node)) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+void ContactsTree::destroy(Node *node)
+{
+    if (node) {
+        destroy(node->left);
+        destroy(node->right);
+        delete node;
+    }
+}
+
+} //namespace
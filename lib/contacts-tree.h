@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_CONTACTS_TREE_H__
+#define __GALERA_CONTACTS_TREE_H__
+
+#include <QtCore/QList>
+#include <QtCore/QHash>
+
+namespace galera
+{
+
+class ContactEntry;
+class ContactEntryLessThan;
+
+// Sorted sequence of contact entries backed by a treap where each node keeps the size
+// of its subtree. This allows insert, remove and rank/select operations in O(log n)
+// instead of the O(n) shuffle of a sorted QList.
+class ContactsTree
+{
+public:
+    ContactsTree();
+    ~ContactsTree();
+
+    // insert the entry after any other entry considered equal by 'lessThan'
+    void insert(ContactEntry *entry, ContactEntryLessThan &lessThan);
+    // insert the entry at the end of the sequence
+    void append(ContactEntry *entry);
+    bool remove(ContactEntry *entry);
+    // move the entry to the correct position, returns the new position
+    int update(ContactEntry *entry, ContactEntryLessThan &lessThan);
+    // replace the full content with a already sorted list
+    void rebuild(const QList<ContactEntry*> &sorted);
+    void clear();
+
+    bool contains(ContactEntry *entry) const;
+    int indexOf(ContactEntry *entry) const;
+    ContactEntry *at(int index) const;
+    int size() const;
+    QList<ContactEntry*> values() const;
+    QList<ContactEntry*> mid(int pos, int length = -1) const;
+
+private:
+    class Node
+    {
+    public:
+        ContactEntry *entry;
+        Node *left;
+        Node *right;
+        Node *parent;
+        int size;
+        uint priority;
+    };
+
+    Node *m_root;
+    QHash<ContactEntry*, Node*> m_nodes;
+    uint m_seed;
+
+    ContactsTree(const ContactsTree &other);
+
+    Node *createNode(ContactEntry *entry);
+    uint nextPriority();
+    int upperBound(ContactEntry *entry, ContactEntryLessThan &lessThan) const;
+    void insertAt(Node *node, int pos);
+    void detach(Node *node);
+
+    static int nodeSize(Node *node);
+    static void updateNode(Node *node);
+    static void split(Node *node, int pos, Node **left, Node **right);
+    static Node *merge(Node *left, Node *right);
+    static Node *select(Node *node, int index);
+    static Node *next(Node *node);
+    static void destroy(Node *node);
+};
+
+} //namespace
+
+#endif
@@ -51,6 +51,7 @@ void DirtyContactsNotify::insertAddedContacts(QSet<QString> ids)
     }
 
     m_contactsAdded += addedIds;
+    m_journal.append(ChangeJournal::Added, ids);
     m_timer.start();
 }
 
@@ -66,9 +67,15 @@ void DirtyContactsNotify::clear()
     m_contactsChanged.clear();
     m_contactsAdded.clear();
     m_contactsRemoved.clear();
+    m_journal.reset();
     m_timer.stop();
 }
 
+ChangeJournal *DirtyContactsNotify::journal()
+{
+    return &m_journal;
+}
+
 void DirtyContactsNotify::insertRemovedContacts(QSet<QString> ids)
 {
     if (!m_adaptor || !m_adaptor->isReady()) {
@@ -85,6 +92,7 @@ void DirtyContactsNotify::insertRemovedContacts(QSet<QString> ids)
     }
 
     m_contactsRemoved += removedIds;
+    m_journal.append(ChangeJournal::Removed, ids);
     m_timer.start();
 }
 
@@ -95,6 +103,7 @@ void DirtyContactsNotify::insertChangedContacts(QSet<QString> ids)
     }
 
     m_contactsChanged += ids;
+    m_journal.append(ChangeJournal::Updated, ids);
     m_timer.start();
 }
 
@@ -25,6 +25,8 @@
 #include <QtCore/QString>
 #include <QtCore/QPointer>
 
+#include "change-journal.h"
+
 namespace galera {
 
 class AddressBookAdaptor;
@@ -44,6 +46,8 @@ public:
     void insertAddedContacts(QSet<QString> ids);
     void flush();
     void clear();
+    // all changes notified, used by the clients that missed the signals
+    ChangeJournal *journal();
 
 private Q_SLOTS:
     void emitSignals();
@@ -54,6 +58,7 @@ private:
     QSet<QString> m_contactsChanged;
     QSet<QString> m_contactsAdded;
     QSet<QString> m_contactsRemoved;
+    ChangeJournal m_journal;
 };
 
 
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filter-planner.h"
+
+#include "common/parsed-phone-number.h"
+
+#include <QtCore/QSet>
+#include <QtCore/QDebug>
+
+#include <QtContacts/QContactGuid>
+#include <QtContacts/QContactEmailAddress>
+#include <QtContacts/QContactSyncTarget>
+#include <QtContacts/QContactIdFilter>
+#include <QtContacts/QContactDetailFilter>
+#include <QtContacts/QContactUnionFilter>
+#include <QtContacts/QContactIntersectionFilter>
+
+using namespace QtContacts;
+
+namespace galera
+{
+
+FilterPlanner::FilterPlanner(const ContactsMap *contacts)
+    : m_contacts(contacts)
+{
+    m_plan = fullScan();
+}
+
+bool FilterPlanner::plan(const Filter &filter)
+{
+    m_plan = planFilter(filter.toContactFilter());
+
+    // the indexes does not help if we need to visit all contacts anyway
+    if (!m_plan.fullScan && (m_plan.cost >= m_contacts->size()) && !m_plan.lookups.isEmpty()) {
+        m_plan = fullScan();
+    }
+    return !m_plan.fullScan;
+}
+
+int FilterPlanner::cost() const
+{
+    return m_plan.cost;
+}
+
+QList<ContactEntry*> FilterPlanner::candidates() const
+{
+    if (m_plan.fullScan) {
+        return m_contacts->values();
+    }
+
+    QList<ContactEntry*> result;
+    Q_FOREACH(int pos, positions()) {
+        result << m_contacts->at(pos);
+    }
+    return result;
+}
+
+QList<int> FilterPlanner::positions() const
+{
+    QList<int> result;
+    if (m_plan.fullScan) {
+        result.reserve(m_contacts->size());
+        for (int i = 0; i < m_contacts->size(); i++) {
+            result << i;
+        }
+        return result;
+    }
+
+    QSet<ContactEntry*> entries;
+    Q_FOREACH(const Lookup &l, m_plan.lookups) {
+        Q_FOREACH(ContactEntry *entry, m_contacts->lookup(l.index, l.value)) {
+            entries.insert(entry);
+        }
+    }
+
+    // keep the contacts map order, this way the result does not need to be sorted again
+    result.reserve(entries.size());
+    Q_FOREACH(ContactEntry *entry, entries) {
+        result << m_contacts->indexOf(entry);
+    }
+    qSort(result);
+    return result;
+}
+
+FilterPlanner::Plan FilterPlanner::planFilter(const QContactFilter &filter) const
+{
+    switch (filter.type()) {
+    case QContactFilter::IdFilter:
+    {
+        const QContactIdFilter idf(filter);
+        Plan result = emptyPlan();
+        Q_FOREACH(const QContactId &id, idf.ids()) {
+            Plan idPlan = lookup(ContactsMap::IdIndex, QString::fromUtf8(id.localId()));
+            result.cost += idPlan.cost;
+            result.lookups += idPlan.lookups;
+        }
+        return result;
+    }
+
+    case QContactFilter::ContactDetailFilter:
+        return planDetailFilter(filter);
+
+    case QContactFilter::IntersectionFilter:
+    {
+        // all terms must match, use the term that returns less entries
+        const QContactIntersectionFilter cif(filter);
+        if (cif.filters().isEmpty()) {
+            return emptyPlan();
+        }
+
+        Plan best = fullScan();
+        Q_FOREACH(const QContactFilter &f, cif.filters()) {
+            Plan termPlan = planFilter(f);
+            if (!termPlan.fullScan && (best.fullScan || (termPlan.cost < best.cost))) {
+                best = termPlan;
+            }
+        }
+        return best;
+    }
+
+    case QContactFilter::UnionFilter:
+    {
+        // any term can match, every term must be solved by the indexes
+        const QContactUnionFilter uf(filter);
+        Plan result = emptyPlan();
+        Q_FOREACH(const QContactFilter &f, uf.filters()) {
+            Plan termPlan = planFilter(f);
+            if (termPlan.fullScan) {
+                return termPlan;
+            }
+            result.cost += termPlan.cost;
+            result.lookups += termPlan.lookups;
+        }
+        return result;
+    }
+
+    default:
+        return fullScan();
+    }
+}
+
+FilterPlanner::Plan FilterPlanner::planDetailFilter(const QContactFilter &filter) const
+{
+    const QContactDetailFilter cdf(filter);
+    const QString value = cdf.value().toString();
+    const QContactFilter::MatchFlags flags = cdf.matchFlags();
+    // MatchExactly, MatchContains, MatchStartsWith or MatchEndsWith
+    const int matchMode = (flags & 7);
+
+    if (value.isEmpty() || (flags & QContactFilter::MatchKeypadCollation)) {
+        return fullScan();
+    }
+
+    if (flags & QContactFilter::MatchPhoneNumber) {
+        // the phone index uses the last 7 diallable chars of each number
+        if ((matchMode == QContactFilter::MatchExactly) ||
+            ((matchMode == QContactFilter::MatchEndsWith) &&
+             (ParsedPhoneNumber::normalize(value).size() >= 7))) {
+            return lookup(ContactsMap::PhoneIndex, value);
+        }
+        return fullScan();
+    }
+
+    if ((cdf.detailType() == QContactDetail::TypeGuid) &&
+        (cdf.detailField() == QContactGuid::FieldGuid) &&
+        (flags == QContactFilter::MatchExactly)) {
+        return lookup(ContactsMap::IdIndex, value);
+    }
+
+    if ((cdf.detailType() == QContactDetail::TypeEmailAddress) &&
+        (cdf.detailField() == QContactEmailAddress::FieldEmailAddress) &&
+        (matchMode == QContactFilter::MatchExactly)) {
+        return lookup(ContactsMap::EmailIndex, value);
+    }
+
+    if ((cdf.detailType() == QContactDetail::TypeSyncTarget) &&
+        (cdf.detailField() == QContactSyncTarget::FieldSyncTarget + 1) &&
+        (flags == QContactFilter::MatchExactly)) {
+        return lookup(ContactsMap::SourceIndex, value);
+    }
+
+    if (ContactsMap::isNameField(cdf.detailType(), cdf.detailField()) &&
+        ((matchMode == QContactFilter::MatchExactly) ||
+         (matchMode == QContactFilter::MatchStartsWith))) {
+        return lookup(ContactsMap::NameIndex, value);
+    }
+
+    return fullScan();
+}
+
+FilterPlanner::Plan FilterPlanner::lookup(ContactsMap::Index index, const QString &value) const
+{
+    Lookup l;
+    l.index = index;
+    l.value = value;
+
+    Plan result;
+    result.fullScan = false;
+    result.cost = m_contacts->estimate(index, value);
+    result.lookups << l;
+    return result;
+}
+
+// plan for filters that does not match any contact
+FilterPlanner::Plan FilterPlanner::emptyPlan()
+{
+    Plan result;
+    result.fullScan = false;
+    result.cost = 0;
+    return result;
+}
+
+FilterPlanner::Plan FilterPlanner::fullScan() const
+{
+    Plan result;
+    result.fullScan = true;
+    result.cost = m_contacts->size();
+    return result;
+}
+
+} //namespace
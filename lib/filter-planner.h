@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_FILTER_PLANNER_H__
+#define __GALERA_FILTER_PLANNER_H__
+
+#include "contacts-map.h"
+
+#include "common/filter.h"
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+#include <QtContacts/QContactFilter>
+
+namespace galera
+{
+
+// Choose the ContactsMap indexes used to find the contacts that can match a filter.
+// The cost of each plan is the number of entries returned by the indexes, intersections
+// use the cheapest term and unions merge the lookups of all terms.
+class FilterPlanner
+{
+public:
+    FilterPlanner(const ContactsMap *contacts);
+
+    // returns false if the filter can not be solved by the indexes, in that case
+    // all contacts need to be tested
+    bool plan(const Filter &filter);
+    int cost() const;
+    // entries that may match the filter, in the same order as the contacts map
+    QList<ContactEntry*> candidates() const;
+    // sorted positions on the contacts map of the entries returned by candidates()
+    QList<int> positions() const;
+
+private:
+    class Lookup
+    {
+    public:
+        ContactsMap::Index index;
+        QString value;
+    };
+
+    class Plan
+    {
+    public:
+        bool fullScan;
+        int cost;
+        QList<Lookup> lookups;
+    };
+
+    const ContactsMap *m_contacts;
+    Plan m_plan;
+
+    Plan planFilter(const QtContacts::QContactFilter &filter) const;
+    Plan planDetailFilter(const QtContacts::QContactFilter &filter) const;
+    Plan lookup(ContactsMap::Index index, const QString &value) const;
+    Plan fullScan() const;
+
+    static Plan emptyPlan();
+};
+
+} //namespace
+
+#endif
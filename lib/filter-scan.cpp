@@ -0,0 +1,178 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filter-scan.h"
+
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+namespace galera
+{
+
+class FilterScanHelper : public QRunnable
+{
+public:
+    FilterScanHelper(const QSharedPointer<FilterScan> &scan)
+        : m_scan(scan)
+    {
+    }
+
+    void run()
+    {
+        m_scan->run();
+    }
+
+private:
+    // keep the scan alive if the helper starts after the scan is done
+    QSharedPointer<FilterScan> m_scan;
+};
+
+FilterScan::FilterScan(const Filter &filter,
+                       const QSharedPointer<const ContactsSnapshot> &snapshot,
+                       const QList<int> &positions,
+                       bool showInvisible,
+                       int maxCount)
+    : m_filter(filter),
+      m_snapshot(snapshot),
+      m_positions(positions),
+      m_showInvisible(showInvisible),
+      m_maxCount(maxCount),
+      m_canceled(0),
+      m_claimedChunks(0),
+      m_doneChunks(0),
+      m_completeChunks(0),
+      m_completeMatches(0)
+{
+    for (int begin = 0; begin < m_positions.size(); begin += ChunkSize) {
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = qMin(begin + ChunkSize, m_positions.size());
+        chunk.done = false;
+        m_chunks << chunk;
+    }
+}
+
+void FilterScan::exec(const QSharedPointer<FilterScan> &scan)
+{
+    // the current thread is one of the workers
+    int helpers = qMin(QThread::idealThreadCount(), scan->m_chunks.size()) - 1;
+    for (int i = 0; i < helpers; i++) {
+        if (!QThreadPool::globalInstance()->tryStart(new FilterScanHelper(scan))) {
+            break;
+        }
+    }
+
+    scan->run();
+    scan->wait();
+}
+
+void FilterScan::cancel()
+{
+    m_canceled.storeRelease(1);
+}
+
+bool FilterScan::isCanceled() const
+{
+    return (m_canceled.loadAcquire() != 0);
+}
+
+QList<int> FilterScan::result() const
+{
+    QList<int> result;
+    Q_FOREACH(const Chunk &chunk, m_chunks) {
+        result += chunk.matches;
+        if ((m_maxCount > 0) && (result.size() >= m_maxCount)) {
+            return result.mid(0, m_maxCount);
+        }
+    }
+    return result;
+}
+
+void FilterScan::run()
+{
+    int chunk;
+    while (claim(&chunk)) {
+        testChunk(&m_chunks[chunk]);
+        finishChunk(chunk);
+    }
+}
+
+bool FilterScan::claim(int *chunk)
+{
+    if (isCanceled()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // the first chunks already found enough contacts
+    if ((m_maxCount > 0) && (m_completeMatches >= m_maxCount)) {
+        return false;
+    }
+
+    if (m_claimedChunks >= m_chunks.size()) {
+        return false;
+    }
+
+    *chunk = m_claimedChunks++;
+    return true;
+}
+
+void FilterScan::testChunk(Chunk *chunk)
+{
+    const QVector<ContactSnapshotEntry> &entries = m_snapshot->entries;
+    for (int i = chunk->begin; i < chunk->end; i++) {
+        if (isCanceled()) {
+            return;
+        }
+
+        int pos = m_positions.at(i);
+        const ContactSnapshotEntry &entry = entries.at(pos);
+        if ((m_showInvisible || entry.visible) &&
+            m_filter.test(entry.contact, entry.deletedAt, &entry.phoneNumbers)) {
+            chunk->matches << pos;
+            if ((m_maxCount > 0) && (chunk->matches.size() >= m_maxCount)) {
+                return;
+            }
+        }
+    }
+}
+
+void FilterScan::finishChunk(int chunk)
+{
+    QMutexLocker locker(&m_mutex);
+    m_chunks[chunk].done = true;
+    m_doneChunks++;
+
+    while ((m_completeChunks < m_chunks.size()) && m_chunks.at(m_completeChunks).done) {
+        m_completeMatches += m_chunks.at(m_completeChunks).matches.size();
+        m_completeChunks++;
+    }
+    m_chunkDone.wakeAll();
+}
+
+// wait for the chunks claimed by the helpers
+void FilterScan::wait()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_doneChunks < m_claimedChunks) {
+        m_chunkDone.wait(&m_mutex);
+    }
+}
+
+} //namespace
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GALERA_FILTER_SCAN_H__
+#define __GALERA_FILTER_SCAN_H__
+
+#include "contacts-map.h"
+
+#include "common/filter.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+namespace galera
+{
+
+// Test the filter on the snapshot contacts using more than one core. The positions are
+// split in chunks that are claimed in order by the calling thread and by helpers started
+// on the idle threads of the global QThreadPool. The calling thread never waits for a
+// helper that did not start, so a busy pool only makes the scan sequential.
+class FilterScan
+{
+public:
+    FilterScan(const Filter &filter,
+               const QSharedPointer<const ContactsSnapshot> &snapshot,
+               const QList<int> &positions,
+               bool showInvisible,
+               int maxCount);
+
+    // test all positions, returns when all chunks are done or the scan was canceled
+    static void exec(const QSharedPointer<FilterScan> &scan);
+
+    void cancel();
+    bool isCanceled() const;
+    // positions of the contacts that match the filter in the snapshot order, limited to maxCount
+    QList<int> result() const;
+
+    static const int ChunkSize = 512;
+
+private:
+    class Chunk
+    {
+    public:
+        int begin;
+        int end;
+        bool done;
+        QList<int> matches;
+    };
+
+    Filter m_filter;
+    QSharedPointer<const ContactsSnapshot> m_snapshot;
+    QList<int> m_positions;
+    bool m_showInvisible;
+    int m_maxCount;
+
+    QVector<Chunk> m_chunks;
+    QAtomicInt m_canceled;
+
+    // protect the fields below
+    QMutex m_mutex;
+    QWaitCondition m_chunkDone;
+    int m_claimedChunks;
+    int m_doneChunks;
+    // number of chunks done in sequence from the first one and their matches
+    int m_completeChunks;
+    int m_completeMatches;
+
+    void run();
+    bool claim(int *chunk);
+    void testChunk(Chunk *chunk);
+    void finishChunk(int chunk);
+    void wait();
+
+    friend class FilterScanHelper;
+};
+
+} //namespace
+
+#endif
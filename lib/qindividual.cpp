@@ -157,6 +157,7 @@ QIndividual::QIndividual(FolksIndividual *individual, FolksIndividualAggregator
       m_aggregator(aggregator),
       m_contact(0),
       m_currentUpdate(0),
+      m_version(0),
       m_visible(true)
 {
     if (m_supportedExtendedDetails.isEmpty()) {
@@ -195,6 +196,11 @@ QString QIndividual::id() const
     return m_id;
 }
 
+uint QIndividual::version() const
+{
+    return m_version;
+}
+
 QtContacts::QContactDetail QIndividual::getUid() const
 {
     QContactGuid uid;
@@ -784,6 +790,53 @@ QtContacts::QContact QIndividual::copy(QList<QContactDetail::DetailType> fields)
     return copy(contact(), fields);
 }
 
+QString QIndividual::vcard(const QList<QContactDetail::DetailType> &fields)
+{
+    QString result = cachedVcard(fields);
+    if (result.isEmpty()) {
+        result = VCardParser::contactToVcard(copy(fields));
+        setCachedVcard(fields, m_version, result);
+    }
+    return result;
+}
+
+QString QIndividual::cachedVcard(const QList<QContactDetail::DetailType> &fields) const
+{
+    return m_vcards.value(vcardKey(fields));
+}
+
+void QIndividual::setCachedVcard(const QList<QContactDetail::DetailType> &fields, uint version, const QString &vcard)
+{
+    // the clients use only a few field sets, avoid keep vCards of old requests
+    static const int maxFieldSets = 4;
+
+    if ((version != m_version) || vcard.isEmpty()) {
+        return;
+    }
+
+    if (m_vcards.size() >= maxFieldSets) {
+        m_vcards.clear();
+    }
+    m_vcards.insert(vcardKey(fields), vcard);
+}
+
+QString QIndividual::vcardKey(const QList<QContactDetail::DetailType> &fields)
+{
+    QList<int> types;
+    Q_FOREACH(QContactDetail::DetailType type, fields) {
+        if (!types.contains(type)) {
+            types << type;
+        }
+    }
+    qSort(types);
+
+    QStringList key;
+    Q_FOREACH(int type, types) {
+        key << QString::number(type);
+    }
+    return key.join(",");
+}
+
 QtContacts::QContact QIndividual::copy(const QContact &c, QList<QContactDetail::DetailType> fields)
 {
     QList<QContactDetail> details;
@@ -886,11 +939,23 @@ QtContacts::QContact &QIndividual::contact()
         QContact contact;
         contact.setId(QContactId("qtcontacts:galera:", m_id.toUtf8()));
         updateContact(&contact);
+
+        m_phoneNumbers.clear();
+        Q_FOREACH(const QContactPhoneNumber &phone, contact.details<QContactPhoneNumber>()) {
+            m_phoneNumbers << ParsedPhoneNumber(phone.number());
+        }
         m_contact = new QContact(contact);
     }
     return *m_contact;
 }
 
+const QList<ParsedPhoneNumber> &QIndividual::phoneNumbers()
+{
+    // make sure that the contact and the numbers are loaded
+    contact();
+    return m_phoneNumbers;
+}
+
 void QIndividual::updatePersonas()
 {
     Q_FOREACH(FolksPersona *p, m_personas.values()) {
@@ -1117,6 +1182,8 @@ void QIndividual::clear()
         delete m_contact;
         m_contact = 0;
     }
+    m_vcards.clear();
+    m_version++;
 }
 
 void QIndividual::addListener(QObject *object, const char *slot)
@@ -1813,6 +1880,8 @@ void QIndividual::markAsDirty()
     delete m_contact;
     m_contact = 0;
     m_deletedAt = QDateTime();
+    m_vcards.clear();
+    m_version++;
 }
 
 void QIndividual::enableAutoLink(bool flag)
@@ -19,8 +19,11 @@
 #ifndef __GALERA_QINDIVIDUAL_H__
 #define __GALERA_QINDIVIDUAL_H__
 
+#include "common/parsed-phone-number.h"
+
 #include <QtCore/QString>
 #include <QtCore/QList>
+#include <QtCore/QHash>
 #include <QtCore/QMultiHash>
 #include <QtCore/QMutex>
 #include <QtCore/QDateTime>
@@ -45,8 +48,17 @@ public:
     ~QIndividual();
 
     QString id() const;
+    uint version() const;
     QtContacts::QContact &contact();
+    // phone numbers of the contact already normalized and parsed
+    const QList<ParsedPhoneNumber> &phoneNumbers();
     QtContacts::QContact copy(QList<QtContacts::QContactDetail::DetailType> fields);
+    // vCard of the contact with only the 'fields' details, the vCards are cached until the contact changes
+    QString vcard(const QList<QtContacts::QContactDetail::DetailType> &fields = QList<QtContacts::QContactDetail::DetailType>());
+    // returns an empty string if the vCard for 'fields' is not cached
+    QString cachedVcard(const QList<QtContacts::QContactDetail::DetailType> &fields) const;
+    // store a vCard exported from the contact 'version', it is ignored if the contact changed after that
+    void setCachedVcard(const QList<QtContacts::QContactDetail::DetailType> &fields, uint version, const QString &vcard);
     bool update(const QString &vcard, QObject *object, const char *slot);
     bool update(const QtContacts::QContact &contact, QObject *object, const char *slot);
     void setIndividual(FolksIndividual *individual);
@@ -75,6 +87,9 @@ private:
     FolksIndividual *m_individual;
     FolksIndividualAggregator *m_aggregator;
     QtContacts::QContact *m_contact;
+    QList<ParsedPhoneNumber> m_phoneNumbers;
+    // exported vCards of the current contact version by field set
+    QHash<QString, QString> m_vcards;
     UpdateContactRequest *m_currentUpdate;
     QList<QPair<QObject*, QMetaMethod> > m_listeners;
     QMap<QString, FolksPersona*> m_personas;
@@ -83,6 +98,8 @@ private:
     QMetaObject::Connection m_updateConnection;
     QMutex m_contactLock;
     QDateTime m_deletedAt;
+    // incremented every time the contact info is invalidated
+    uint m_version;
     bool m_visible;
     static bool m_autoLink;
     static QStringList m_supportedExtendedDetails;
@@ -91,6 +108,7 @@ private:
     QIndividual(const QIndividual &);
 
     void notifyUpdate();
+    static QString vcardKey(const QList<QtContacts::QContactDetail::DetailType> &fields);
 
     QMultiHash<QString, QString> parseDetails(FolksAbstractFieldDetails *details) const;
     void markAsDirty();
@@ -43,6 +43,13 @@ bool sortDetails<QContactDetail::TypeEmailAddress>(const QContactDetail &d1, con
            d2.value(QtContacts::QContactEmailAddress::FieldEmailAddress).toString();
 }
 
+// the detail type of a running folks change call
+class DetailChangeData
+{
+public:
+    UpdateContactRequest *m_request;
+    QContactDetail::DetailType m_type;
+};
 
 UpdateContactRequest::UpdateContactRequest(QtContacts::QContact newContact, QIndividual *parent, QObject *listener, const char *slot)
     : QObject(),
@@ -51,7 +58,10 @@ UpdateContactRequest::UpdateContactRequest(QtContacts::QContact newContact, QInd
       m_currentPersona(0),
       m_eventLoop(0),
       m_newContact(newContact),
-      m_currentPersonaIndex(0)
+      m_currentPersonaIndex(0),
+      m_runningChanges(0),
+      m_emailPending(false),
+      m_extendedDetailsPending(false)
 {
     int slotIndex = listener->metaObject()->indexOfSlot(++slot);
     if (slotIndex == -1) {
@@ -88,7 +98,6 @@ void UpdateContactRequest::invokeSlot(const QString &errorMessage)
 
 void UpdateContactRequest::start()
 {
-    m_currentDetailType = QContactDetail::TypeAddress;
     m_originalContact = m_parent->contact();
     m_personas = m_parent->personas();
     m_currentPersonaIndex = 0;
@@ -239,56 +248,70 @@ QList<QtContacts::QContactDetail> UpdateContactRequest::detailsFromPersona(QtCon
 
 void UpdateContactRequest::updateAddress()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeAddress,
-                                                                       m_currentPersonaIndex,
-                                                                       &originalPref);
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeAddress,
                                                           m_currentPersonaIndex,
                                                           &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_POSTAL_ADDRESS_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "Adderess diff";
-        GeeSet *newSet = SET_AFD_NEW();
-
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactAddress addr = static_cast<QContactAddress>(newDetail);
-
-            FolksPostalAddress *pa;
-            QByteArray postOfficeBox = addr.postOfficeBox().toUtf8();
-            QByteArray street = addr.street().toUtf8();
-            QByteArray locality = addr.locality().toUtf8();
-            QByteArray region = addr.region().toUtf8();
-            QByteArray postcode = addr.postcode().toUtf8();
-            QByteArray country = addr.country().toUtf8();
-
-            pa = folks_postal_address_new(postOfficeBox.constData(),
-                                          NULL,
-                                          street.constData(),
-                                          locality.constData(),
-                                          region.constData(),
-                                          postcode.constData(),
-                                          country.constData(),
-                                          NULL,
-                                          NULL);
-
-            FolksPostalAddressFieldDetails *field = folks_postal_address_field_details_new(pa, NULL);
-            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
-            gee_collection_add(GEE_COLLECTION(newSet), field);
-            g_object_unref(field);
-            g_object_unref(pa);
+    GeeSet *newSet = SET_AFD_NEW();
+
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactAddress addr = static_cast<QContactAddress>(newDetail);
+
+        FolksPostalAddress *pa;
+        QByteArray postOfficeBox = addr.postOfficeBox().toUtf8();
+        QByteArray street = addr.street().toUtf8();
+        QByteArray locality = addr.locality().toUtf8();
+        QByteArray region = addr.region().toUtf8();
+        QByteArray postcode = addr.postcode().toUtf8();
+        QByteArray country = addr.country().toUtf8();
+
+        pa = folks_postal_address_new(postOfficeBox.constData(),
+                                      NULL,
+                                      street.constData(),
+                                      locality.constData(),
+                                      region.constData(),
+                                      postcode.constData(),
+                                      country.constData(),
+                                      NULL,
+                                      NULL);
+
+        FolksPostalAddressFieldDetails *field = folks_postal_address_field_details_new(pa, NULL);
+        DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
+        gee_collection_add(GEE_COLLECTION(newSet), field);
+        g_object_unref(field);
+        g_object_unref(pa);
+    }
+
+    folks_postal_address_details_change_postal_addresses(FOLKS_POSTAL_ADDRESS_DETAILS(m_currentPersona),
+                                                         newSet,
+                                                         (GAsyncReadyCallback) updateDetailsDone,
+                                                         detailChangeData(QContactDetail::TypeAddress));
+    g_object_unref(newSet);
+}
+
+void UpdateContactRequest::updateAvatarRev()
+{
+    QContactExtendedDetail originalAvatarRev;
+    QContactExtendedDetail newAvatarRev;
+    Q_FOREACH(const QContactExtendedDetail &det,
+              originalDetailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0)) {
+        if (det.name() == "X-AVATAR-REV") {
+            originalAvatarRev = det;
+            break;
         }
-
-        folks_postal_address_details_change_postal_addresses(FOLKS_POSTAL_ADDRESS_DETAILS(m_currentPersona),
-                                                             newSet,
-                                                             (GAsyncReadyCallback) updateDetailsDone,
-                                                             this);
-        g_object_unref(newSet);
-    } else {
-        updateDetailsDone(0, 0, this);
+    }
+    Q_FOREACH(const QContactExtendedDetail &det,
+              detailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0)) {
+        if (det.name() == "X-AVATAR-REV") {
+            newAvatarRev = det;
+            break;
+        }
+    }
+    // if the avatar changed and the rev still the same we need to reset it to force a sync
+    if (originalAvatarRev.data() == newAvatarRev.data()) {
+        newAvatarRev.setData("");
+        m_newContact.saveDetail(&newAvatarRev);
     }
 }
 
@@ -297,484 +320,559 @@ void UpdateContactRequest::updateAvatar()
     QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeAvatar, m_currentPersonaIndex, 0);
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeAvatar, m_currentPersonaIndex, 0);
 
-    if (m_currentPersona &&
-        FOLKS_IS_AVATAR_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, newDetails)) {
-        qDebug() << "avatar diff:"
-                 << "\n\t" << originalDetails.size() << (originalDetails.size() > 0 ? originalDetails[0] : QContactDetail()) << "\n"
-                 << "\n\t" << newDetails.size() << (newDetails.size() > 0 ? newDetails[0] : QContactDetail());
-
-        // update avatar version if necessary
-        QContactExtendedDetail originalAvatarRev;
-        QContactExtendedDetail newAvatarRev;
-        Q_FOREACH(const QContactExtendedDetail &det,
-                  originalDetailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0)) {
-            if (det.name() == "X-AVATAR-REV") {
-                originalAvatarRev = det;
-                break;
-            }
-        }
-        Q_FOREACH(const QContactExtendedDetail &det,
-                  detailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0)) {
-            if (det.name() == "X-AVATAR-REV") {
-                newAvatarRev = det;
-                break;
-            }
-        }
-        // if the avatar changed and the rev still the same we need to reset it to force a sync
-        if (originalAvatarRev.data() == newAvatarRev.data()) {
-            newAvatarRev.setData("");
-            m_newContact.saveDetail(&newAvatarRev);
-        }
+    //Only supports one avatar
+    QUrl avatarUri;
+    QUrl oldAvatarUri;
 
-        //Only supports one avatar
-        QUrl avatarUri;
-        QUrl oldAvatarUri;
+    if (originalDetails.count()) {
+        QContactAvatar avatar = static_cast<QContactAvatar>(originalDetails[0]);
+        oldAvatarUri = avatar.imageUrl();
+    }
 
-        if (originalDetails.count()) {
-            QContactAvatar avatar = static_cast<QContactAvatar>(originalDetails[0]);
-            oldAvatarUri = avatar.imageUrl();
-        }
+    if (newDetails.count()) {
+        QContactAvatar avatar = static_cast<QContactAvatar>(newDetails[0]);
+        avatarUri = avatar.imageUrl();
+    }
 
-        if (newDetails.count()) {
-            QContactAvatar avatar = static_cast<QContactAvatar>(newDetails[0]);
-            avatarUri = avatar.imageUrl();
-        }
+    if ((avatarUri != oldAvatarUri) &&
+        (avatarUri.isLocalFile() || avatarUri.isEmpty())){
+        GFileIcon *avatarFileIcon = NULL;
+        if(!avatarUri.isEmpty()) {
+            QString formattedUri = avatarUri.toString(QUrl::RemoveUserInfo);
 
-        if ((avatarUri != oldAvatarUri) &&
-            (avatarUri.isLocalFile() || avatarUri.isEmpty())){
-            GFileIcon *avatarFileIcon = NULL;
-            if(!avatarUri.isEmpty()) {
-                QString formattedUri = avatarUri.toString(QUrl::RemoveUserInfo);
-
-                if(!formattedUri.isEmpty()) {
-                    QByteArray uriUtf8 = formattedUri.toUtf8();
-                    GFile *avatarFile = g_file_new_for_uri(uriUtf8.constData());
-                    avatarFileIcon = G_FILE_ICON(g_file_icon_new(avatarFile));
-                    g_object_unref(avatarFile);
-                }
+            if(!formattedUri.isEmpty()) {
+                QByteArray uriUtf8 = formattedUri.toUtf8();
+                GFile *avatarFile = g_file_new_for_uri(uriUtf8.constData());
+                avatarFileIcon = G_FILE_ICON(g_file_icon_new(avatarFile));
+                g_object_unref(avatarFile);
             }
+        }
 
-            folks_avatar_details_change_avatar(FOLKS_AVATAR_DETAILS(m_currentPersona),
-                                               G_LOADABLE_ICON(avatarFileIcon),
-                                               (GAsyncReadyCallback) updateDetailsDone,
-                                               this);
-            if (avatarFileIcon) {
-                g_object_unref(avatarFileIcon);
-            }
-            return;
+        folks_avatar_details_change_avatar(FOLKS_AVATAR_DETAILS(m_currentPersona),
+                                           G_LOADABLE_ICON(avatarFileIcon),
+                                           (GAsyncReadyCallback) updateDetailsDone,
+                                           detailChangeData(QContactDetail::TypeAvatar));
+        if (avatarFileIcon) {
+            g_object_unref(avatarFileIcon);
         }
+    } else {
+        detailChangeDone(QContactDetail::TypeAvatar, QString());
     }
-    updateDetailsDone(0, 0, this);
 }
 
 void UpdateContactRequest::updateBirthday()
 {
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeBirthday, m_currentPersonaIndex, 0);
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeBirthday, m_currentPersonaIndex, 0);
 
-    if (m_currentPersona &&
-        FOLKS_IS_BIRTHDAY_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, newDetails)) {
-        qDebug() << "birthday diff";
-        //Only supports one birthday
-        QDateTime dateTimeBirthday;
-        if (newDetails.count()) {
-            QContactBirthday birthday = static_cast<QContactBirthday>(newDetails[0]);
-            if (!birthday.isEmpty()) {
-                dateTimeBirthday = birthday.dateTime();
-            }
+    //Only supports one birthday
+    QDateTime dateTimeBirthday;
+    if (newDetails.count()) {
+        QContactBirthday birthday = static_cast<QContactBirthday>(newDetails[0]);
+        if (!birthday.isEmpty()) {
+            dateTimeBirthday = birthday.dateTime();
         }
+    }
 
-        GDateTime *dateTime = NULL;
-        if (dateTimeBirthday.isValid()) {
-            dateTime = g_date_time_new_from_unix_utc(dateTimeBirthday.toMSecsSinceEpoch() / 1000);
-        }
-        folks_birthday_details_change_birthday(FOLKS_BIRTHDAY_DETAILS(m_currentPersona),
-                                               dateTime,
-                                               (GAsyncReadyCallback) updateDetailsDone,
-                                               this);
-        if (dateTime) {
-            g_date_time_unref(dateTime);
-        }
-    } else {
-        updateDetailsDone(0, 0, this);
+    GDateTime *dateTime = NULL;
+    if (dateTimeBirthday.isValid()) {
+        dateTime = g_date_time_new_from_unix_utc(dateTimeBirthday.toMSecsSinceEpoch() / 1000);
+    }
+    folks_birthday_details_change_birthday(FOLKS_BIRTHDAY_DETAILS(m_currentPersona),
+                                           dateTime,
+                                           (GAsyncReadyCallback) updateDetailsDone,
+                                           detailChangeData(QContactDetail::TypeBirthday));
+    if (dateTime) {
+        g_date_time_unref(dateTime);
     }
 }
 
 void UpdateContactRequest::updateFullName(const QString &fullName)
 {
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeDisplayLabel, m_currentPersonaIndex, 0);
-    if (m_currentPersona &&
-        FOLKS_IS_NAME_DETAILS(m_currentPersona) &&
-        originalDetails.size() > 0 &&
-        (originalDetails[0].value(QContactDisplayLabel::FieldLabel).toString() != fullName)) {
-        qDebug() << "Full Name diff:"
-                 << "\n\t" << originalDetails.size() << (originalDetails.size() > 0 ? originalDetails[0] : QContactDetail()) << "\n"
-                 << "\n\t" << fullName;
-        //Only supports one fullName
-        QByteArray fullNameUtf8 = fullName.toUtf8();
-        folks_name_details_change_full_name(FOLKS_NAME_DETAILS(m_currentPersona),
-                                            fullNameUtf8.constData(),
-                                            (GAsyncReadyCallback) updateDetailsDone,
-                                            this);
-    } else {
-        updateDetailsDone(0, 0, this);
-    }
+    //Only supports one fullName
+    QByteArray fullNameUtf8 = fullName.toUtf8();
+    folks_name_details_change_full_name(FOLKS_NAME_DETAILS(m_currentPersona),
+                                        fullNameUtf8.constData(),
+                                        (GAsyncReadyCallback) updateDetailsDone,
+                                        detailChangeData(QContactDetail::TypeDisplayLabel));
 }
 
 void UpdateContactRequest::updateEmail()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeEmailAddress,
-                                                                       m_currentPersonaIndex,
-                                                                       &originalPref);
-
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeEmailAddress,
                                                           m_currentPersonaIndex,
                                                           &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_EMAIL_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "email diff";
-        GeeSet *newSet = SET_AFD_NEW();
+    GeeSet *newSet = SET_AFD_NEW();
 
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactEmailAddress email = static_cast<QContactEmailAddress>(newDetail);
-            FolksEmailFieldDetails *field;
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactEmailAddress email = static_cast<QContactEmailAddress>(newDetail);
+        FolksEmailFieldDetails *field;
 
-            QByteArray emailAddress = email.emailAddress().toUtf8();
-            field = folks_email_field_details_new(emailAddress.constData(), NULL);
-            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
-            gee_collection_add(GEE_COLLECTION(newSet), field);
-            g_object_unref(field);
-        }
-
-        folks_email_details_change_email_addresses(FOLKS_EMAIL_DETAILS(m_currentPersona),
-                                                   newSet,
-                                                   (GAsyncReadyCallback) updateDetailsDone,
-                                                   this);
-        g_object_unref(newSet);
-    } else {
-        updateDetailsDone(0, 0, this);
+        QByteArray emailAddress = email.emailAddress().toUtf8();
+        field = folks_email_field_details_new(emailAddress.constData(), NULL);
+        DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
+        gee_collection_add(GEE_COLLECTION(newSet), field);
+        g_object_unref(field);
     }
+
+    folks_email_details_change_email_addresses(FOLKS_EMAIL_DETAILS(m_currentPersona),
+                                               newSet,
+                                               (GAsyncReadyCallback) updateDetailsDone,
+                                               detailChangeData(QContactDetail::TypeEmailAddress));
+    g_object_unref(newSet);
 }
 
 void UpdateContactRequest::updateName()
 {
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeName, m_currentPersonaIndex, 0);
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeName, m_currentPersonaIndex, 0);
 
-    if (m_currentPersona &&
-        FOLKS_IS_NAME_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, newDetails)) {
-        //Only supports one fullName
-        FolksStructuredName *sn = 0;
-        if (newDetails.count()) {
-            QContactName name = static_cast<QContactName>(newDetails[0]);
-
-            QByteArray lastName = name.lastName().toUtf8();
-            QByteArray firstName = name.firstName().toUtf8();
-            QByteArray middleName = name.middleName().toUtf8();
-            QByteArray prefix = name.prefix().toUtf8();
-            QByteArray suffix = name.suffix().toUtf8();
-            sn = folks_structured_name_new(lastName.constData(),
-                                           firstName.constData(),
-                                           middleName.constData(),
-                                           prefix.constData(),
-                                           suffix.constData());
-        }
+    //Only supports one fullName
+    FolksStructuredName *sn = 0;
+    if (newDetails.count()) {
+        QContactName name = static_cast<QContactName>(newDetails[0]);
 
-        folks_name_details_change_structured_name(FOLKS_NAME_DETAILS(m_currentPersona),
-                                                  sn,
-                                                  (GAsyncReadyCallback) updateDetailsDone,
-                                                  this);
-        if (sn) {
-            g_object_unref(sn);
-        }
-    } else {
-        updateDetailsDone(0, 0, this);
+        QByteArray lastName = name.lastName().toUtf8();
+        QByteArray firstName = name.firstName().toUtf8();
+        QByteArray middleName = name.middleName().toUtf8();
+        QByteArray prefix = name.prefix().toUtf8();
+        QByteArray suffix = name.suffix().toUtf8();
+        sn = folks_structured_name_new(lastName.constData(),
+                                       firstName.constData(),
+                                       middleName.constData(),
+                                       prefix.constData(),
+                                       suffix.constData());
+    }
+
+    folks_name_details_change_structured_name(FOLKS_NAME_DETAILS(m_currentPersona),
+                                              sn,
+                                              (GAsyncReadyCallback) updateDetailsDone,
+                                              detailChangeData(QContactDetail::TypeName));
+    if (sn) {
+        g_object_unref(sn);
     }
 }
 
 void UpdateContactRequest::updateNickname()
 {
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeNickname, m_currentPersonaIndex, 0);
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeNickname, m_currentPersonaIndex, 0);
 
-    if (m_currentPersona &&
-        FOLKS_IS_NAME_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, newDetails)) {
-        qDebug() << "Nickname diff";
-        //Only supports one fullName
-        QString nicknameValue;
-        if (newDetails.count()) {
-            QContactNickname nickname = static_cast<QContactNickname>(newDetails[0]);
-            nicknameValue = nickname.nickname();
-        }
-
-        QByteArray nicknameValueUtf8 = nicknameValue.toUtf8();
-        folks_name_details_change_nickname(FOLKS_NAME_DETAILS(m_currentPersona),
-                                           nicknameValueUtf8.constData(),
-                                           (GAsyncReadyCallback) updateDetailsDone,
-                                           this);
-    } else {
-        updateDetailsDone(0, 0, this);
+    //Only supports one fullName
+    QString nicknameValue;
+    if (newDetails.count()) {
+        QContactNickname nickname = static_cast<QContactNickname>(newDetails[0]);
+        nicknameValue = nickname.nickname();
     }
+
+    QByteArray nicknameValueUtf8 = nicknameValue.toUtf8();
+    folks_name_details_change_nickname(FOLKS_NAME_DETAILS(m_currentPersona),
+                                       nicknameValueUtf8.constData(),
+                                       (GAsyncReadyCallback) updateDetailsDone,
+                                       detailChangeData(QContactDetail::TypeNickname));
 }
 
 void UpdateContactRequest::updateNote()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeNote, m_currentPersonaIndex, &originalPref);
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeNote, m_currentPersonaIndex, &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_EMAIL_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "notes diff";
-        GeeSet *newSet = SET_AFD_NEW();
+    GeeSet *newSet = SET_AFD_NEW();
 
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactNote note = static_cast<QContactNote>(newDetail);
-            FolksNoteFieldDetails *field;
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactNote note = static_cast<QContactNote>(newDetail);
+        FolksNoteFieldDetails *field;
 
-            QByteArray noteUtf8 = note.note().toUtf8();
-            field = folks_note_field_details_new(noteUtf8.constData(), 0, 0);
-            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
-            gee_collection_add(GEE_COLLECTION(newSet), field);
-            g_object_unref(field);
-        }
-
-        folks_note_details_change_notes(FOLKS_NOTE_DETAILS(m_currentPersona),
-                                        newSet,
-                                        (GAsyncReadyCallback) updateDetailsDone,
-                                        this);
-        g_object_unref(newSet);
-    } else {
-        updateDetailsDone(0, 0, this);
+        QByteArray noteUtf8 = note.note().toUtf8();
+        field = folks_note_field_details_new(noteUtf8.constData(), 0, 0);
+        DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
+        gee_collection_add(GEE_COLLECTION(newSet), field);
+        g_object_unref(field);
     }
+
+    folks_note_details_change_notes(FOLKS_NOTE_DETAILS(m_currentPersona),
+                                    newSet,
+                                    (GAsyncReadyCallback) updateDetailsDone,
+                                    detailChangeData(QContactDetail::TypeNote));
+    g_object_unref(newSet);
 }
 
 void UpdateContactRequest::updateOnlineAccount()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeOnlineAccount,
-                                                                       m_currentPersonaIndex,
-                                                                       &originalPref);
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeOnlineAccount,
                                                           m_currentPersonaIndex,
                                                           &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_IM_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "OnlineAccounts diff";
-        GeeMultiMap *imMap = GEE_MULTI_MAP_AFD_NEW(FOLKS_TYPE_IM_FIELD_DETAILS);
+    GeeMultiMap *imMap = GEE_MULTI_MAP_AFD_NEW(FOLKS_TYPE_IM_FIELD_DETAILS);
 
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactOnlineAccount account = static_cast<QContactOnlineAccount>(newDetail);
-            FolksImFieldDetails *field;
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactOnlineAccount account = static_cast<QContactOnlineAccount>(newDetail);
+        FolksImFieldDetails *field;
 
-            if (account.protocol() != QContactOnlineAccount::ProtocolUnknown) {
-                QByteArray accountUri = account.accountUri().toUtf8();
-                field = folks_im_field_details_new(accountUri.constData(), NULL);
-                DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), account, account == prefDetail);
+        if (account.protocol() != QContactOnlineAccount::ProtocolUnknown) {
+            QByteArray accountUri = account.accountUri().toUtf8();
+            field = folks_im_field_details_new(accountUri.constData(), NULL);
+            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), account, account == prefDetail);
 
-                QString protocolName(DetailContextParser::accountProtocolName(account.protocol()));
-                QByteArray protocolNameUtf8 = protocolName.toUtf8();
-                gee_multi_map_set(imMap, protocolNameUtf8.constData(), field);
+            QString protocolName(DetailContextParser::accountProtocolName(account.protocol()));
+            QByteArray protocolNameUtf8 = protocolName.toUtf8();
+            gee_multi_map_set(imMap, protocolNameUtf8.constData(), field);
 
-                g_object_unref(field);
-            }
+            g_object_unref(field);
         }
+    }
 
-       folks_im_details_change_im_addresses(FOLKS_IM_DETAILS(m_currentPersona),
-                                            imMap,
-                                            (GAsyncReadyCallback) updateDetailsDone,
-                                            this);
+    folks_im_details_change_im_addresses(FOLKS_IM_DETAILS(m_currentPersona),
+                                         imMap,
+                                         (GAsyncReadyCallback) updateDetailsDone,
+                                         detailChangeData(QContactDetail::TypeOnlineAccount));
 
-        g_object_unref(imMap);
-    } else {
-        updateDetailsDone(0, 0, this);
-    }
+    g_object_unref(imMap);
 }
 
 void UpdateContactRequest::updateOrganization()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeOrganization,
-                                                                       m_currentPersonaIndex,
-                                                                       &originalPref);
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeOrganization,
                                                           m_currentPersonaIndex,
                                                           &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_ROLE_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "Organization diff";
-        GeeSet *newSet = SET_AFD_NEW();
+    GeeSet *newSet = SET_AFD_NEW();
 
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactOrganization org = static_cast<QContactOrganization>(newDetail);
-            FolksRoleFieldDetails *field;
-            FolksRole *roleValue;
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactOrganization org = static_cast<QContactOrganization>(newDetail);
+        FolksRoleFieldDetails *field;
+        FolksRole *roleValue;
 
-            QByteArray title = org.title().isEmpty() ? "" : org.title().toUtf8();
-            QByteArray name = org.name().isEmpty() ? "" : org.name().toUtf8();
-            QByteArray roleName = org.role().isEmpty() ? "" : org.role().toUtf8();
+        QByteArray title = org.title().isEmpty() ? "" : org.title().toUtf8();
+        QByteArray name = org.name().isEmpty() ? "" : org.name().toUtf8();
+        QByteArray roleName = org.role().isEmpty() ? "" : org.role().toUtf8();
 
-            roleValue = folks_role_new(title.constData(), name.constData(), "");
-            folks_role_set_role(roleValue, roleName.constData());
-            field = folks_role_field_details_new(roleValue, NULL);
+        roleValue = folks_role_new(title.constData(), name.constData(), "");
+        folks_role_set_role(roleValue, roleName.constData());
+        field = folks_role_field_details_new(roleValue, NULL);
 
-            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
-            gee_collection_add(GEE_COLLECTION(newSet), field);
-            g_object_unref(field);
-            g_object_unref(roleValue);
-        }
+        DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
+        gee_collection_add(GEE_COLLECTION(newSet), field);
+        g_object_unref(field);
+        g_object_unref(roleValue);
+    }
 
-        folks_role_details_change_roles(FOLKS_ROLE_DETAILS(m_currentPersona),
-                                        newSet,
-                                        (GAsyncReadyCallback) updateDetailsDone,
-                                        this);
+    folks_role_details_change_roles(FOLKS_ROLE_DETAILS(m_currentPersona),
+                                    newSet,
+                                    (GAsyncReadyCallback) updateDetailsDone,
+                                    detailChangeData(QContactDetail::TypeOrganization));
 
-        g_object_unref(newSet);
-    } else {
-        updateDetailsDone(0, 0, this);
-    }
+    g_object_unref(newSet);
 }
 
 void UpdateContactRequest::updatePhone()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypePhoneNumber,
-                                                                       m_currentPersonaIndex,
-                                                                       &originalPref);
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypePhoneNumber,
                                                           m_currentPersonaIndex,
                                                           &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_PHONE_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "Phone diff:"
-                 << "\n\t" << originalDetails.size() << (originalDetails.size() > 0 ? originalDetails[0] : QContactDetail()) << "\n"
-                 << "\n\t" << newDetails.size() << (newDetails.size() > 0 ? newDetails[0] : QContactDetail());
-
-        GeeSet *newSet = SET_AFD_NEW();
+    GeeSet *newSet = SET_AFD_NEW();
 
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactPhoneNumber phone = static_cast<QContactPhoneNumber>(newDetail);
-            FolksPhoneFieldDetails *field;
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactPhoneNumber phone = static_cast<QContactPhoneNumber>(newDetail);
+        FolksPhoneFieldDetails *field;
 
-            QByteArray phoneNumber = phone.number().toUtf8();
-            field = folks_phone_field_details_new(phoneNumber.constData(), NULL);
-            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
-            gee_collection_add(GEE_COLLECTION(newSet), field);
-            g_object_unref(field);
-        }
-
-        folks_phone_details_change_phone_numbers(FOLKS_PHONE_DETAILS(m_currentPersona),
-                                                 newSet,
-                                                 (GAsyncReadyCallback) updateDetailsDone,
-                                                 this);
-        g_object_unref(newSet);
-    } else {
-        updateDetailsDone(0, 0, this);
+        QByteArray phoneNumber = phone.number().toUtf8();
+        field = folks_phone_field_details_new(phoneNumber.constData(), NULL);
+        DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, newDetail == prefDetail);
+        gee_collection_add(GEE_COLLECTION(newSet), field);
+        g_object_unref(field);
     }
+
+    folks_phone_details_change_phone_numbers(FOLKS_PHONE_DETAILS(m_currentPersona),
+                                             newSet,
+                                             (GAsyncReadyCallback) updateDetailsDone,
+                                             detailChangeData(QContactDetail::TypePhoneNumber));
+    g_object_unref(newSet);
 }
 
 void UpdateContactRequest::updateUrl()
 {
-    QContactDetail originalPref;
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeUrl,
-                                                                       m_currentPersonaIndex,
-                                                                       &originalPref);
-
     QContactDetail prefDetail;
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeUrl,
                                                           m_currentPersonaIndex,
                                                           &prefDetail);
 
-    if (m_currentPersona &&
-        FOLKS_IS_URL_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, originalPref, newDetails, prefDetail)) {
-        qDebug() << "Url diff";
-        GeeSet *newSet = SET_AFD_NEW();
+    GeeSet *newSet = SET_AFD_NEW();
 
-        Q_FOREACH(QContactDetail newDetail, newDetails) {
-            QContactUrl url = static_cast<QContactUrl>(newDetail);
-            FolksUrlFieldDetails *field;
+    Q_FOREACH(QContactDetail newDetail, newDetails) {
+        QContactUrl url = static_cast<QContactUrl>(newDetail);
+        FolksUrlFieldDetails *field;
 
-            QByteArray urlValue = url.url().toUtf8();
-            field = folks_url_field_details_new(urlValue.constData(), NULL);
-            DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, prefDetail == newDetail);
-            gee_collection_add(GEE_COLLECTION(newSet), field);
-            g_object_unref(field);
-        }
-
-        folks_url_details_change_urls(FOLKS_URL_DETAILS(m_currentPersona),
-                                      newSet,
-                                      (GAsyncReadyCallback) updateDetailsDone,
-                                      this);
-        g_object_unref(newSet);
-    } else {
-        updateDetailsDone(0, 0, this);
+        QByteArray urlValue = url.url().toUtf8();
+        field = folks_url_field_details_new(urlValue.constData(), NULL);
+        DetailContextParser::parseContext(FOLKS_ABSTRACT_FIELD_DETAILS(field), newDetail, prefDetail == newDetail);
+        gee_collection_add(GEE_COLLECTION(newSet), field);
+        g_object_unref(field);
     }
+
+    folks_url_details_change_urls(FOLKS_URL_DETAILS(m_currentPersona),
+                                  newSet,
+                                  (GAsyncReadyCallback) updateDetailsDone,
+                                  detailChangeData(QContactDetail::TypeUrl));
+    g_object_unref(newSet);
 }
 
 void UpdateContactRequest::updateFavorite()
 {
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeFavorite, m_currentPersonaIndex, 0);
     QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeFavorite, m_currentPersonaIndex, 0);
 
+    bool isFavorite = false;
+    if (newDetails.count()) {
+        QContactFavorite favorite = static_cast<QContactFavorite>(newDetails[0]);
+        isFavorite = favorite.isFavorite();
+    }
+    folks_favourite_details_change_is_favourite(FOLKS_FAVOURITE_DETAILS(m_currentPersona),
+                                                isFavorite,
+                                                (GAsyncReadyCallback) updateDetailsDone,
+                                                detailChangeData(QContactDetail::TypeFavorite));
+}
+
+void UpdateContactRequest::updateExtendedDetails()
+{
+    QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0);
+    QIndividual::setExtendedDetails(m_currentPersona, newDetails);
+    detailChangeDone(QContactDetail::TypeExtendedDetail, QString());
+}
+
+bool UpdateContactRequest::personaSupports(FolksPersona *persona, QtContacts::QContactDetail::DetailType type)
+{
+    switch(type) {
+    case QContactDetail::TypeAddress:
+        return FOLKS_IS_POSTAL_ADDRESS_DETAILS(persona);
+    case QContactDetail::TypeAvatar:
+        return FOLKS_IS_AVATAR_DETAILS(persona);
+    case QContactDetail::TypeBirthday:
+        return FOLKS_IS_BIRTHDAY_DETAILS(persona);
+    case QContactDetail::TypeDisplayLabel:
+    case QContactDetail::TypeName:
+    case QContactDetail::TypeNickname:
+        return FOLKS_IS_NAME_DETAILS(persona);
+    case QContactDetail::TypeEmailAddress:
+        return FOLKS_IS_EMAIL_DETAILS(persona);
+    case QContactDetail::TypeExtendedDetail:
+        return true;
+    case QContactDetail::TypeFavorite:
+        return FOLKS_IS_FAVOURITE_DETAILS(persona);
+    case QContactDetail::TypeNote:
+        return FOLKS_IS_NOTE_DETAILS(persona);
+    case QContactDetail::TypeOnlineAccount:
+        return FOLKS_IS_IM_DETAILS(persona);
+    case QContactDetail::TypeOrganization:
+        return FOLKS_IS_ROLE_DETAILS(persona);
+    case QContactDetail::TypePhoneNumber:
+        return FOLKS_IS_PHONE_DETAILS(persona);
+    case QContactDetail::TypeUrl:
+        return FOLKS_IS_URL_DETAILS(persona);
+    default:
+        //TODO: Anniversary, Family, Gender, GeoLocation, GlobalPresence, Hobby, Ringtone, Tag
+        return false;
+    }
+}
+
+bool UpdateContactRequest::isDetailChanged(QtContacts::QContactDetail::DetailType type) const
+{
+    QContactDetail originalPref;
+    QList<QContactDetail> originalDetails = originalDetailsFromPersona(type, m_currentPersonaIndex, &originalPref);
+
+    if (type == QContactDetail::TypeDisplayLabel) {
+        return (originalDetails.size() > 0) &&
+               (originalDetails[0].value(QContactDisplayLabel::FieldLabel).toString() != QIndividual::displayName(m_newContact));
+    }
+
+    QContactDetail prefDetail;
+    QList<QContactDetail> newDetails = detailsFromPersona(type, m_currentPersonaIndex, &prefDetail);
+
     // as default all contacts has favorte set to false
-    if (newDetails.isEmpty()) {
+    if ((type == QContactDetail::TypeFavorite) && newDetails.isEmpty()) {
         QContactFavorite fav;
         fav.setFavorite(false);
         newDetails << fav;
     }
 
-    if (m_currentPersona &&
-        FOLKS_IS_FAVOURITE_DETAILS(m_currentPersona) &&
-        !isEqual(originalDetails, newDetails)) {
-        qDebug() << "Favorite diff:"
-                 << "\n\t" << originalDetails.size() << (originalDetails.size() > 0 ? originalDetails[0] : QContactDetail()) << "\n"
-                 << "\n\t" << newDetails.size() << (newDetails.size() > 0 ? newDetails[0] : QContactDetail());
+    return !isEqual(originalDetails, originalPref, newDetails, prefDetail);
+}
+
+QList<QtContacts::QContactDetail::DetailType> UpdateContactRequest::changedDetails()
+{
+    static const QList<QContactDetail::DetailType> types = QList<QContactDetail::DetailType>()
+        << QContactDetail::TypeAddress
+        << QContactDetail::TypeAvatar
+        << QContactDetail::TypeBirthday
+        << QContactDetail::TypeDisplayLabel
+        << QContactDetail::TypeEmailAddress
+        // must be compared after the avatar, the avatar change can update the avatar revision
+        << QContactDetail::TypeExtendedDetail
+        << QContactDetail::TypeFavorite
+        << QContactDetail::TypeName
+        << QContactDetail::TypeNickname
+        << QContactDetail::TypeNote
+        << QContactDetail::TypeOnlineAccount
+        << QContactDetail::TypeOrganization
+        << QContactDetail::TypePhoneNumber
+        << QContactDetail::TypeUrl;
+
+    QList<QContactDetail::DetailType> changed;
+    Q_FOREACH(QContactDetail::DetailType type, types) {
+        if (personaSupports(m_currentPersona, type) && isDetailChanged(type)) {
+            qDebug() << "Detail diff:" << type;
+            if (type == QContactDetail::TypeAvatar) {
+                updateAvatarRev();
+            }
+            changed << type;
+        }
+    }
+    return changed;
+}
+
+void UpdateContactRequest::updateDetails()
+{
+    QList<QContactDetail::DetailType> changed = changedDetails();
+    m_runningChanges = changed.size();
+    m_errorMessage.clear();
+
+    //WORKAROUND: Folks automatically add online accounts based on e-mail address
+    // for example user@gmail.com will create a jabber account, and this causes some
+    // confusions on the service during the update, because of that we first update
+    // the online account and this will avoid problems with the automatic update
+    // from folks
+    m_emailPending = changed.contains(QContactDetail::TypeOnlineAccount) &&
+                     changed.contains(QContactDetail::TypeEmailAddress);
 
-        //Only supports one fullName
-        bool isFavorite = false;
-        if (newDetails.count()) {
-            QContactFavorite favorite = static_cast<QContactFavorite>(newDetails[0]);
-            isFavorite = favorite.isFavorite();
+    // the extended details are saved with a synchronous EDS call that commits the whole
+    // contact, it must not run while the folks changes of the persona are in flight
+    m_extendedDetailsPending = changed.contains(QContactDetail::TypeExtendedDetail) &&
+                               (changed.size() > 1);
+
+    if (changed.isEmpty()) {
+        personaDone();
+        return;
+    }
+
+    // the folks changes of different details are independent and run at same time
+    Q_FOREACH(QContactDetail::DetailType type, changed) {
+        if (m_emailPending && (type == QContactDetail::TypeEmailAddress)) {
+            continue;
         }
-        folks_favourite_details_change_is_favourite(FOLKS_FAVOURITE_DETAILS(m_currentPersona),
-                                                    isFavorite,
-                                                    (GAsyncReadyCallback) updateDetailsDone,
-                                                    this);
-    } else {
-        updateDetailsDone(0, 0, this);
+        if (m_extendedDetailsPending && (type == QContactDetail::TypeExtendedDetail)) {
+            continue;
+        }
+        updateDetail(type);
     }
 }
 
-void UpdateContactRequest::updateExtendedDetails()
+void UpdateContactRequest::updateDetail(QtContacts::QContactDetail::DetailType type)
 {
-    QList<QContactDetail> originalDetails = originalDetailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0);
-    QList<QContactDetail> newDetails = detailsFromPersona(QContactDetail::TypeExtendedDetail, m_currentPersonaIndex, 0);
-    if (m_currentPersona &&
-        !isEqual(originalDetails, newDetails)) {
-        qDebug() << "Extended details diff";
-        QIndividual::setExtendedDetails(m_currentPersona, newDetails);
+    switch(type) {
+    case QContactDetail::TypeAddress:
+        updateAddress();
+        break;
+    case QContactDetail::TypeAvatar:
+        updateAvatar();
+        break;
+    case QContactDetail::TypeBirthday:
+        updateBirthday();
+        break;
+    case QContactDetail::TypeDisplayLabel:
+        updateFullName(QIndividual::displayName(m_newContact));
+        break;
+    case QContactDetail::TypeEmailAddress:
+        updateEmail();
+        break;
+    case QContactDetail::TypeExtendedDetail:
+        updateExtendedDetails();
+        break;
+    case QContactDetail::TypeFavorite:
+        updateFavorite();
+        break;
+    case QContactDetail::TypeName:
+        updateName();
+        break;
+    case QContactDetail::TypeNickname:
+        updateNickname();
+        break;
+    case QContactDetail::TypeNote:
+        updateNote();
+        break;
+    case QContactDetail::TypeOnlineAccount:
+        updateOnlineAccount();
+        break;
+    case QContactDetail::TypeOrganization:
+        updateOrganization();
+        break;
+    case QContactDetail::TypePhoneNumber:
+        updatePhone();
+        break;
+    case QContactDetail::TypeUrl:
+        updateUrl();
+        break;
+    default:
+        qWarning() << "Update not implemented for" << type;
+        detailChangeDone(type, QString());
+        break;
+    }
+}
+
+void UpdateContactRequest::detailChangeDone(QtContacts::QContactDetail::DetailType type, const QString &errorMessage)
+{
+    m_runningChanges--;
+    if (!errorMessage.isEmpty()) {
+        qWarning() << "Fail to update contact" << errorMessage;
+        if (m_errorMessage.isEmpty()) {
+            m_errorMessage = errorMessage;
+        }
+    }
+
+    //WORKAROUND: see updateDetails
+    if ((type == QContactDetail::TypeOnlineAccount) && m_emailPending) {
+        m_emailPending = false;
+        if (m_errorMessage.isEmpty()) {
+            updateEmail();
+            return;
+        }
+        m_runningChanges--;
+    }
+
+    // the extended details are the last change of the persona, see updateDetails
+    if (m_extendedDetailsPending && (m_runningChanges == 1)) {
+        m_extendedDetailsPending = false;
+        if (m_errorMessage.isEmpty()) {
+            updateExtendedDetails();
+            return;
+        }
+        m_runningChanges--;
+    }
+
+    if (m_runningChanges == 0) {
+        personaDone();
     }
-    updateDetailsDone(0, 0, this);
+}
+
+void UpdateContactRequest::personaDone()
+{
+    g_object_unref(m_currentPersona);
+    m_currentPersona = 0;
+
+    if (m_errorMessage.isEmpty()) {
+        updatePersona();
+    } else {
+        invokeSlot(m_errorMessage);
+    }
+}
+
+gpointer UpdateContactRequest::detailChangeData(QtContacts::QContactDetail::DetailType type)
+{
+    DetailChangeData *data = new DetailChangeData;
+    data->m_request = this;
+    data->m_type = type;
+    return data;
 }
 
 void UpdateContactRequest::updatePersona()
@@ -788,9 +886,8 @@ void UpdateContactRequest::updatePersona()
     } else {
         m_currentPersona = m_personas[m_currentPersonaIndex];
         g_object_ref(m_currentPersona);
-        m_currentDetailType = QContactDetail::TypeUndefined;
         m_currentPersonaIndex++;
-        updateDetailsDone(0, 0, this);
+        updateDetails();
     }
 }
 
@@ -855,98 +952,17 @@ QString UpdateContactRequest::callDetailChangeFinish(QtContacts::QContactDetail:
 
 void UpdateContactRequest::updateDetailsDone(GObject *detail, GAsyncResult *result, gpointer userdata)
 {
-    UpdateContactRequest *self = static_cast<UpdateContactRequest*>(userdata);
+    DetailChangeData *data = static_cast<DetailChangeData*>(userdata);
+    UpdateContactRequest *self = data->m_request;
+    QContactDetail::DetailType type = data->m_type;
+    delete data;
 
     QString errorMessage;
-    if (detail && result) {
-        if (FOLKS_IS_PERSONA(detail)) {
-            // This is a normal field update
-            errorMessage = self->callDetailChangeFinish(static_cast<QContactDetail::DetailType>(self->m_currentDetailType),
-                                                        FOLKS_PERSONA(detail),
-                                                        result);
-        }
-
-        if (!errorMessage.isEmpty()) {
-            qWarning() << "Fail to update contact" << errorMessage;
-            self->invokeSlot(errorMessage);
-            return;
-        }
-    }
-
-    self->m_currentDetailType += 1;
-    switch(static_cast<QContactDetail::DetailType>(self->m_currentDetailType)) {
-    case QContactDetail::TypeAddress:
-        self->updateAddress();
-        break;
-    case QContactDetail::TypeAvatar:
-        self->updateAvatar();
-        break;
-    case QContactDetail::TypeBirthday:
-        self->updateBirthday();
-        break;
-    case QContactDetail::TypeDisplayLabel:
-        self->updateFullName(QIndividual::displayName(self->m_newContact));
-        break;
-    case QContactDetail::TypeEmailAddress:
-        //WORKAROUND: Folks automatically add online accounts based on e-mail address
-        // for example user@gmail.com will create a jabber account, and this causes some
-        // confusions on the service during the update, because of that we first update
-        // the online account and this will avoid problems with the automatic update ]
-        // from folks
-        self->updateOnlineAccount();
-        break;
-    case QContactDetail::TypeExtendedDetail:
-        self->updateExtendedDetails();
-        break;
-    case QContactDetail::TypeFavorite:
-        self->updateFavorite();
-        break;
-    case QContactDetail::TypeName:
-        self->updateName();
-        break;
-    case QContactDetail::TypeNickname:
-        self->updateNickname();
-        break;
-    case QContactDetail::TypeNote:
-        self->updateNote();
-        break;
-    case QContactDetail::TypeOnlineAccount:
-        //WORKAROUND: see TypeEmailAddress update clause
-        self->updateEmail();
-        break;
-    case QContactDetail::TypeOrganization:
-        self->updateOrganization();
-        break;
-    case QContactDetail::TypePhoneNumber:
-        self->updatePhone();
-        break;
-    case QContactDetail::TypeUrl:
-        self->updateUrl();
-        break;
-    case QContactDetail::TypeAnniversary:
-    case QContactDetail::TypeFamily:
-    case QContactDetail::TypeGender:
-    case QContactDetail::TypeGeoLocation:
-    case QContactDetail::TypeGlobalPresence:
-    case QContactDetail::TypeHobby:
-    case QContactDetail::TypeRingtone:
-    case QContactDetail::TypeTag:
-    case QContactDetail::TypeTimestamp:
-        //TODO
-    case QContactDetail::TypeGuid:
-    case QContactDetail::TypeType:
-        updateDetailsDone(0, 0, self);
-        break;
-    case QContactDetail::TypeVersion:
-        g_object_unref(self->m_currentPersona);
-        self->m_currentPersona = 0;
-        self->updatePersona();
-        break;
-    default:
-        qWarning() << "Update not implemented for" << self->m_currentDetailType;
-        updateDetailsDone(0, 0, self);
-        break;
+    if (detail && result && FOLKS_IS_PERSONA(detail)) {
+        // This is a normal field update
+        errorMessage = self->callDetailChangeFinish(type, FOLKS_PERSONA(detail), result);
     }
+    self->detailChangeDone(type, errorMessage);
 }
 
 } // namespace
@@ -64,9 +64,13 @@ private:
     QList<FolksPersona*> m_personas;
     QtContacts::QContact m_originalContact;
     QtContacts::QContact m_newContact;
-    int m_currentDetailType;
     QMetaMethod m_slot;
     int m_currentPersonaIndex;
+    // number of detail changes not finished for the current persona
+    int m_runningChanges;
+    bool m_emailPending;
+    bool m_extendedDetailsPending;
+    QString m_errorMessage;
 
     void invokeSlot(const QString &errorMessage = QString());
     static bool isEqual(QList<QtContacts::QContactDetail> listA,
@@ -89,7 +93,16 @@ private:
     QList<QtContacts::QContactDetail> detailsFromPersona(QtContacts::QContactDetail::DetailType type,
                                                          int persona,
                                                          QtContacts::QContactDetail *pref) const;
-
+    static bool personaSupports(FolksPersona *persona, QtContacts::QContactDetail::DetailType type);
+    bool isDetailChanged(QtContacts::QContactDetail::DetailType type) const;
+    QList<QtContacts::QContactDetail::DetailType> changedDetails();
+
+    void updateDetails();
+    void updateDetail(QtContacts::QContactDetail::DetailType type);
+    void updateAvatarRev();
+    void detailChangeDone(QtContacts::QContactDetail::DetailType type, const QString &errorMessage);
+    void personaDone();
+    gpointer detailChangeData(QtContacts::QContactDetail::DetailType type);
 
     void updatePersona();
     void updateAddress();
@@ -19,6 +19,8 @@
 #include "view.h"
 #include "view-adaptor.h"
 #include "contacts-map.h"
+#include "filter-planner.h"
+#include "filter-scan.h"
 #include "contact-less-than.h"
 #include "qindividual.h"
 
@@ -31,6 +33,7 @@
 
 #include <QtVersit/QVersitDocument>
 
+#include <QtCore/QHash>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QCoreApplication>
 
@@ -40,65 +43,190 @@ using namespace QtVersit;
 namespace galera
 {
 
+// Reference to a contact on the view result, the contact details are only read from
+// the contacts map when a page is requested
+class ContactHandle
+{
+public:
+    QString id;
+    // QIndividual::version() of the contact when it was added to the view
+    uint version;
+};
+
 class FilterThread: public QRunnable
 {
 public:
-    FilterThread(QString filter, QString sort, int maxCount, bool showInvisible, ContactsMap *allContacts, QObject *parent)
+    FilterThread(QString filter, QString sort, int maxCount, bool showInvisible, ContactsMap *allContacts,
+                 const QSharedPointer<const ContactsSnapshot> &bootSnapshot, QObject *parent)
         : m_parent(parent),
+          m_filterClause(filter),
           m_filter(filter),
           m_sortClause(sort),
-          m_maxCount(maxCount),
           m_allContacts(allContacts),
+          m_validPositions(0),
+          m_maxCount(maxCount),
           m_showInvisible(showInvisible),
           m_canceled(false),
+          m_started(false),
           m_running(false),
-          m_done(false)
+          m_done(false),
+          m_needSort(false)
     {
         setAutoDelete(false);
+
+        if (allContacts || bootSnapshot) {
+            // the thread works on a copy of the contacts, changes done after this point
+            // are applied by the view
+            m_snapshot = allContacts ? allContacts->snapshot() : bootSnapshot;
+
+            // only sort contacts if the contacts was stored in a different order into the contacts map
+            m_needSort = (!m_sortClause.isEmpty() &&
+                          (m_sortClause.toContactSortOrder() != m_snapshot->sortClause.toContactSortOrder()));
+
+            // use the contacts map indexes to avoid test all contacts
+            if (m_filter.isValid() && !m_filter.isEmpty()) {
+                QList<int> positions;
+                if (allContacts) {
+                    FilterPlanner planner(allContacts);
+                    if (!planner.plan(m_filter)) {
+                        qDebug() << "Filter not optimized" << m_filter.toContactFilter();
+                    }
+                    positions = planner.positions();
+                } else {
+                    // the boot snapshot has no indexes, all contacts are tested
+                    positions.reserve(m_snapshot->entries.size());
+                    for (int i = 0; i < m_snapshot->entries.size(); i++) {
+                        positions << i;
+                    }
+                }
+                // the first contacts on the map order are only the first ones on the result if
+                // the result does not need to be sorted again
+                m_scan = QSharedPointer<FilterScan>(new FilterScan(m_filter, m_snapshot, positions,
+                                                                   m_showInvisible,
+                                                                   m_needSort ? 0 : m_maxCount));
+            }
+        }
     }
 
-    QList<QContact> result() const
+    QList<ContactHandle> result() const
     {
         if (isRunning()) {
-            return QList<QContact>();
+            return QList<ContactHandle>();
         } else {
             return m_contacts;
         }
     }
 
-    bool appendContact(const QContact &contact, const QDateTime &deteletedAt)
+    int count() const
     {
-        if (checkContact(contact, deteletedAt)) {
-            addSorted(&m_contacts, contact, m_sortClause);
-            return true;
+        return result().count();
+    }
+
+    // contact details of the handle, the handle could point to a contact already removed
+    // from the map if the removal was not applied yet
+    QContact contact(const ContactHandle &handle) const
+    {
+        if (!m_allContacts) {
+            return m_bootContacts.value(handle.id);
         }
-        return false;
+        ContactEntry *entry = m_allContacts->value(handle.id);
+        return entry ? entry->individual()->contact() : QContact();
     }
 
-    bool removeContact(const QContact &contact)
+    ContactSortKey sortKey(const ContactHandle &handle) const
     {
-        return m_contacts.removeAll(contact);
+        // the map entry caches the sort key of the current contact version
+        ContactEntry *entry = m_allContacts ? m_allContacts->value(handle.id) : 0;
+        return entry ? entry->sortKey(m_sortClause) : ContactSortKey(contact(handle), m_sortClause);
     }
 
-    void chageSort(SortClause clause)
+    // a new filter with the same arguments running on the contacts map
+    FilterThread *clone(ContactsMap *allContacts) const
     {
-        m_sortClause = clause;
-        if (!clause.isEmpty()) {
-            ContactLessThan lessThan(m_sortClause);
-            qSort(m_contacts.begin(), m_contacts.end(), lessThan);
+        return new FilterThread(m_filterClause, m_sortClause.toString(), m_maxCount, m_showInvisible,
+                                allContacts, QSharedPointer<const ContactsSnapshot>(), m_parent);
+    }
+
+    // check if the entry belongs to this view
+    bool accept(ContactEntry *entry)
+    {
+        QIndividual *individual = entry->individual();
+        return ((m_showInvisible || individual->isVisible()) &&
+                checkContact(individual->contact(), individual->deletedAt(), &individual->phoneNumbers()));
+    }
+
+    // add the contact on the sorted position, returns the contact position or -1 if
+    // the contact does not fit on the view
+    int insertContact(ContactEntry *entry)
+    {
+        ContactHandle handle;
+        handle.id = entry->individual()->id();
+        handle.version = entry->individual()->version();
+
+        int pos = m_contacts.size();
+        if (!m_sortClause.isEmpty()) {
+            // use the same sort keys and comparison of the contacts map and of the filter sort
+            ContactSortComparator comparator(m_sortClause);
+            const ContactSortKey toAdd = entry->sortKey(m_sortClause);
+            QList<ContactHandle>::iterator it = std::upper_bound(m_contacts.begin(), m_contacts.end(), toAdd,
+                [this, &comparator](const ContactSortKey &key, const ContactHandle &other) {
+                    return (comparator.compare(key, this->sortKey(other)) < 0);
+                });
+            pos = it - m_contacts.begin();
+        }
+
+        if ((m_maxCount > 0) && (pos >= m_maxCount)) {
+            return -1;
         }
+
+        m_contacts.insert(pos, handle);
+        m_positions.insert(handle.id, pos);
+        m_validPositions = qMin(m_validPositions, pos);
+        return pos;
     }
 
-    void addSorted(QList<QContact> *sorted, const QContact &toAdd, const SortClause& sortOrder)
+    ContactHandle takeContact(int pos)
     {
-        if (!sortOrder.isEmpty()) {
-            ContactLessThan lessThan(sortOrder);
-            QList<QContact>::iterator it(std::upper_bound(sorted->begin(), sorted->end(), toAdd, lessThan));
-            sorted->insert(it, toAdd);
-        } else {
-            // no sort order just add it to the end
-            sorted->append(toAdd);
+        ContactHandle handle = m_contacts.takeAt(pos);
+        m_positions.remove(handle.id);
+        m_validPositions = qMin(m_validPositions, pos);
+        return handle;
+    }
+
+    int indexOf(const QString &id)
+    {
+        // most of the changes are on contacts that are not part of the view
+        QHash<QString, int>::const_iterator it = m_positions.constFind(id);
+        if (it == m_positions.constEnd()) {
+            return -1;
+        }
+
+        if (it.value() >= m_validPositions) {
+            updatePositions();
+        }
+        return m_positions.value(id);
+    }
+
+    int maxCount() const
+    {
+        return m_maxCount;
+    }
+
+    void chageSort(SortClause clause)
+    {
+        m_sortClause = clause;
+
+        QList<QContact> contacts;
+        Q_FOREACH(const ContactHandle &handle, m_contacts) {
+            contacts << contact(handle);
+        }
+
+        QList<ContactHandle> sorted;
+        Q_FOREACH(int i, ContactLessThan::order(contacts, m_sortClause)) {
+            sorted << m_contacts.at(i);
         }
+        m_contacts = sorted;
+        m_validPositions = 0;
     }
 
     void cancel()
@@ -106,6 +234,22 @@ public:
         m_canceledLock.lockForWrite();
         m_canceled = true;
         m_canceledLock.unlock();
+        if (m_scan) {
+            m_scan->cancel();
+        }
+    }
+
+    void start()
+    {
+        if (!m_started && !m_snapshot.isNull()) {
+            m_started = true;
+            QThreadPool::globalInstance()->start(this);
+        }
+    }
+
+    bool isStarted() const
+    {
+        return m_started;
     }
 
     bool isRunning() const
@@ -128,119 +272,130 @@ protected:
 
     void run()
     {
-        if (m_canceled || !m_allContacts) {
+        if (m_canceled || m_snapshot.isNull()) {
             notifyFinished();
             return;
         }
 
-        m_allContacts->lockForRead();
-        // only sort contacts if the contacts was stored in a different order into the contacts map
-        bool needSort = (!m_sortClause.isEmpty() &&
-                         (m_sortClause.toContactSortOrder() != m_allContacts->sort().toContactSortOrder()));
+        const QVector<ContactSnapshotEntry> &entries = m_snapshot->entries;
+        // positions on the snapshot of the contacts that belong to the view
+        QList<int> matches;
         // filter contacts if necessary
         if (m_filter.isValid() && m_filter.isEmpty()) {
-            Q_FOREACH(ContactEntry *entry, m_allContacts->values()) {
-                if ((m_showInvisible || entry->individual()->isVisible()) &&
-                    !entry->individual()->deletedAt().isValid()) {
+            for (int i = 0; i < entries.size(); i++) {
+                const ContactSnapshotEntry &entry = entries.at(i);
+                if ((m_showInvisible || entry.visible) && !entry.deletedAt.isValid()) {
+                    matches << i;
 
-                    QContact contact = entry->individual()->contact();
-
-                    if (needSort) {
-                        addSorted(&m_contacts, contact, m_sortClause);
-                    } else {
-                        m_contacts.append(contact);
-                    }
-
-                    if ((m_maxCount > 0) && (m_maxCount >= m_contacts.size())) {
+                    if (!m_needSort && (m_maxCount > 0) && (matches.size() >= m_maxCount)) {
                         break;
                     }
                 }
             }
         } else if (m_filter.isValid()) {
-            // optmization
-            QList<ContactEntry *> preFilter;
-
-            // check if is a query by id
-            QStringList idsToFilter = m_filter.idsToFilter();
-            if (!idsToFilter.isEmpty()) {
-                preFilter = m_allContacts->values(idsToFilter);
-            } else {
-                // check if is a phone number query
-                QString phoneToFilter = m_filter.phoneNumberToFilter();
-                if (!phoneToFilter.isEmpty()) {
-                    preFilter = m_allContacts->valueByPhone(phoneToFilter);
-                } else {
-                    qDebug() << "Filter not optimized" << m_filter.toContactFilter();
-                    preFilter = m_allContacts->values();
-                }
+            // the contacts are tested in parallel and returned in the snapshot order
+            FilterScan::exec(m_scan);
+            if (m_scan->isCanceled()) {
+                notifyFinished();
+                return;
             }
 
-            Q_FOREACH(ContactEntry *entry, preFilter) {
-                m_canceledLock.lockForRead();
-                if (m_canceled) {
-                    m_canceledLock.unlock();
-                    m_allContacts->unlock();
-                    notifyFinished();
-                    return;
-                }
+            matches = m_scan->result();
+        }
+        // invalid filters does not match any contact
+
+        // sort all matches once, or keep only the first 'maxCount' ones
+        if (m_needSort) {
+            QList<QContact> contacts;
+            contacts.reserve(matches.size());
+            Q_FOREACH(int pos, matches) {
+                contacts << entries.at(pos).contact;
+            }
 
-                QContact contact = entry->individual()->contact();
-                QDateTime deletedAt = entry->individual()->deletedAt();
-                m_canceledLock.unlock();
+            QList<int> sorted;
+            Q_FOREACH(int i, ContactLessThan::order(contacts, m_sortClause, m_maxCount)) {
+                sorted << matches.at(i);
+            }
+            matches = sorted;
+        }
 
-                if ((m_showInvisible || entry->individual()->isVisible()) &&
-                    checkContact(contact, deletedAt)) {
-                    if (needSort) {
-                        addSorted(&m_contacts, contact, m_sortClause);
-                    } else {
-                        m_contacts.append(contact);
-                    }
-                    if ((m_maxCount > 0) && (m_contacts.size() >= m_maxCount)) {
-                        break;
-                    }
-                }
+        m_contacts.reserve(matches.size());
+        m_positions.reserve(matches.size());
+        Q_FOREACH(int pos, matches) {
+            ContactHandle handle;
+            handle.id = entries.at(pos).id;
+            handle.version = entries.at(pos).version;
+            m_positions.insert(handle.id, m_contacts.size());
+            m_contacts << handle;
+            if (!m_allContacts) {
+                // the boot snapshot contacts are not part of the map
+                m_bootContacts.insert(handle.id, entries.at(pos).contact);
             }
-        } else {
-            // invalid filter
-            m_contacts.clear();
         }
 
-        m_allContacts->unlock();
+        m_validPositions = m_contacts.size();
+
+        // release the snapshot, it is not necessary anymore
+        m_snapshot.clear();
         notifyFinished();
     }
 
 private:
+    // update the positions of the contacts moved after the last update
+    void updatePositions()
+    {
+        for (int i = m_validPositions; i < m_contacts.size(); i++) {
+            m_positions[m_contacts.at(i).id] = i;
+        }
+        m_validPositions = m_contacts.size();
+    }
+
     QObject *m_parent;
+    QString m_filterClause;
     Filter m_filter;
     SortClause m_sortClause;
+    // only used on the main thread
     ContactsMap *m_allContacts;
-    QList<QContact> m_contacts;
+    QSharedPointer<const ContactsSnapshot> m_snapshot;
+    QSharedPointer<FilterScan> m_scan;
+    QList<ContactHandle> m_contacts;
+    // contacts of the result when the filter runs on the boot snapshot
+    QHash<QString, QContact> m_bootContacts;
+    // position of each contact on m_contacts, only the positions before
+    // m_validPositions are updated after the contacts move
+    QHash<QString, int> m_positions;
+    int m_validPositions;
 
     int m_maxCount;
     bool m_showInvisible;
     bool m_canceled;
     QReadWriteLock m_canceledLock;
+    bool m_started;
     bool m_running;
     bool m_done;
+    bool m_needSort;
 
-    bool checkContact(const QContact &contact, const QDateTime &deletedAt)
+    bool checkContact(const QContact &contact,
+                      const QDateTime &deletedAt,
+                      const QList<ParsedPhoneNumber> *phoneNumbers = 0)
     {
-        return m_filter.test(contact, deletedAt);
+        return m_filter.test(contact, deletedAt, phoneNumbers);
     }
 };
 
 View::View(const QString &clause, const QString &sort, int maxCount, bool showInvisible,
            const QStringList &sources, ContactsMap *allContacts,
-           QObject *parent)
+           const QSharedPointer<const ContactsSnapshot> &bootSnapshot, QObject *parent)
     : QObject(parent),
       m_sources(sources),
-      m_filterThread(new FilterThread(clause, sort, maxCount, showInvisible, allContacts, this)),
+      m_filterThread(new FilterThread(clause, sort, maxCount, showInvisible, allContacts, bootSnapshot, this)),
+      m_allContacts(allContacts),
       m_adaptor(0),
-      m_waiting(0)
+      m_waiting(0),
+      m_oneShot(false),
+      m_reloading(false)
 {
-    if (allContacts) {
-        QThreadPool::globalInstance()->start(m_filterThread);
-    }
+    m_filterThread->start();
 }
 
 View::~View()
@@ -251,7 +406,7 @@ View::~View()
 void View::close()
 {
     if (m_adaptor) {
-        Q_EMIT m_adaptor->contactsRemoved(0, m_filterThread->result().count());
+        Q_EMIT m_adaptor->contactsRemoved(0, m_filterThread->count());
         Q_EMIT closed();
 
         QDBusConnection conn = QDBusConnection::sessionBus();
@@ -270,6 +425,32 @@ void View::close()
     }
 }
 
+void View::setContactsMap(ContactsMap *allContacts)
+{
+    if (!m_filterThread || (m_allContacts == allContacts)) {
+        return;
+    }
+
+    // the result of the boot snapshot is replaced by the result on the live contacts
+    if (!m_filterThread->done()) {
+        m_filterThread->cancel();
+        waitFilter();
+    }
+    int oldCount = m_filterThread->count();
+    FilterThread *filterThread = m_filterThread->clone(allContacts);
+    delete m_filterThread;
+    m_filterThread = filterThread;
+    m_allContacts = allContacts;
+    m_pendingChanges.clear();
+
+    if (isOpen() && (oldCount > 0)) {
+        Q_EMIT m_adaptor->contactsRemoved(0, oldCount);
+    }
+
+    m_reloading = true;
+    m_filterThread->start();
+}
+
 bool View::isOpen() const
 {
     return (m_adaptor != 0);
@@ -287,9 +468,21 @@ QStringList View::contactsDetails(const QStringList &fields, int startIndex, int
         return QStringList();
     }
 
+    sendContactsDetails(fields, startIndex, pageSize, message);
+    return QStringList();
+}
+
+void View::replyFirstPage(const QStringList &fields, int pageSize, const QDBusMessage &message)
+{
+    m_oneShot = true;
+    sendContactsDetails(fields, 0, pageSize, message);
+}
+
+void View::sendContactsDetails(const QStringList &fields, int startIndex, int pageSize, const QDBusMessage &message)
+{
     waitFilter();
 
-    const QList<QContact> &contacts = m_filterThread->result();
+    const QList<ContactHandle> &contacts = m_filterThread->result();
     if (startIndex < 0) {
         startIndex = 0;
     }
@@ -298,38 +491,127 @@ QStringList View::contactsDetails(const QStringList &fields, int startIndex, int
         pageSize = contacts.count() - startIndex;
     }
 
+    QList<QContactDetail::DetailType> detailFields = FetchHint::parseFieldNames(fields);
+    QStringList vcards;
+    // contacts without a cached vCard, exported in a separated thread
     QList<QContact> pageOfContacts;
+    QVariantList missing;
+    QStringList missingIds;
+    QVariantList missingVersions;
     for(int i = startIndex, iMax = (startIndex + pageSize); i < iMax; i++) {
-        pageOfContacts << QIndividual::copy(contacts.at(i), FetchHint::parseFieldNames(fields));
+        // the contact details are only resolved for the requested page
+        const ContactHandle &handle = contacts.at(i);
+        ContactEntry *entry = m_allContacts ? m_allContacts->value(handle.id) : 0;
+        QString vcard = entry ? entry->individual()->cachedVcard(detailFields) : QString();
+        if (vcard.isEmpty()) {
+            missing << vcards.size();
+            missingIds << handle.id;
+            missingVersions << (entry ? entry->individual()->version() : 0);
+            pageOfContacts << QIndividual::copy(m_filterThread->contact(handle), detailFields);
+        }
+        vcards << vcard;
+    }
+
+    if (pageOfContacts.isEmpty()) {
+        sendReply(message, vcards);
+        return;
     }
 
     VCardParser *parser = new VCardParser(this);
     parser->setProperty("DATA", QVariant::fromValue<QDBusMessage>(message));
+    parser->setProperty("FIELDS", fields);
+    parser->setProperty("VCARDS", vcards);
+    parser->setProperty("MISSING", missing);
+    parser->setProperty("MISSING_IDS", missingIds);
+    parser->setProperty("MISSING_VERSIONS", missingVersions);
     connect(parser, &VCardParser::vcardParsed,
             this, &View::onVCardParsed);
     parser->contactToVcard(pageOfContacts);
-    return QStringList();
 }
 
 void View::onVCardParsed(const QStringList &vcards)
 {
     QObject *sender = QObject::sender();
-    QDBusMessage reply = sender->property("DATA").value<QDBusMessage>().createReply(vcards);
-    QDBusConnection::sessionBus().send(reply);
+    QStringList result = sender->property("VCARDS").toStringList();
+    QVariantList missing = sender->property("MISSING").toList();
+    QStringList missingIds = sender->property("MISSING_IDS").toStringList();
+    QVariantList missingVersions = sender->property("MISSING_VERSIONS").toList();
+    QList<QContactDetail::DetailType> detailFields = FetchHint::parseFieldNames(sender->property("FIELDS").toStringList());
+
+    // merge the exported vCards with the cached ones and cache them for the next requests
+    for (int i = 0; (i < missing.size()) && (i < vcards.size()); i++) {
+        result[missing.at(i).toInt()] = vcards.at(i);
+
+        ContactEntry *entry = m_allContacts ? m_allContacts->value(missingIds.at(i)) : 0;
+        if (entry) {
+            entry->individual()->setCachedVcard(detailFields, missingVersions.at(i).toUInt(), vcards.at(i));
+        }
+    }
+
     sender->deleteLater();
+    sendReply(sender->property("DATA").value<QDBusMessage>(), result);
+}
+
+void View::sendReply(const QDBusMessage &message, const QStringList &vcards)
+{
+    QDBusConnection::sessionBus().send(message.createReply(vcards));
+    if (m_oneShot) {
+        deleteLater();
+    }
 }
 
 void View::onFilterDone()
 {
+    // the view was reloaded with the contacts map
+    if (m_reloading && m_filterThread && m_filterThread->done()) {
+        m_reloading = false;
+        int count = m_filterThread->count();
+        if (isOpen()) {
+            if (count > 0) {
+                Q_EMIT m_adaptor->contactsAdded(0, count);
+            }
+            Q_EMIT countChanged(count);
+        }
+    }
+
+    // apply the changes done on the contacts map while the filter was running
+    QSet<QString> changes = m_pendingChanges;
+    m_pendingChanges.clear();
+    Q_FOREACH(const QString &id, changes) {
+        ContactEntry *entry = m_allContacts->value(id);
+        if (entry) {
+            updateContact(entry);
+        } else if (isOpen()) {
+            removeContact(id);
+        }
+    }
+
     if (m_waiting) {
         m_waiting->quit();
         m_waiting = 0;
     }
 }
 
+// returns true if the change on the contact can be applied on the view result, changes
+// done before the filter finishes are stored and applied by onFilterDone()
+bool View::filterDone(const QString &id)
+{
+    if (!m_filterThread || !m_allContacts) {
+        return false;
+    }
+
+    if (!m_filterThread->done()) {
+        m_pendingChanges << id;
+        return false;
+    }
+
+    return isOpen();
+}
+
 void View::waitFilter()
 {
-    if (m_filterThread && !m_filterThread->done()) {
+    // filters that were not started never finish
+    if (m_filterThread && m_filterThread->isStarted() && !m_filterThread->done()) {
         QEventLoop loop;
         m_waiting = &loop;
         loop.exec();
@@ -344,7 +626,7 @@ int View::count()
 
     waitFilter();
 
-    return m_filterThread->result().count();
+    return m_filterThread->count();
 }
 
 void View::sort(const QString &field)
@@ -392,29 +674,83 @@ void View::unregisterObject(QDBusConnection &connection)
 
 bool View::appendContact(ContactEntry *entry)
 {
-    if (!isOpen()) {
+    if (!filterDone(entry->individual()->id()) || !m_filterThread->accept(entry)) {
         return false;
     }
 
-    if (m_filterThread->appendContact(entry->individual()->contact(),
-                                      entry->individual()->deletedAt())) {
-        Q_EMIT countChanged(m_filterThread->result().count());
-        return true;
+    int pos = m_filterThread->insertContact(entry);
+    if (pos < 0) {
+        return false;
     }
-    return false;
+
+    Q_EMIT m_adaptor->contactsAdded(pos, 1);
+
+    // keep the view size limit
+    int maxCount = m_filterThread->maxCount();
+    if ((maxCount > 0) && (m_filterThread->count() > maxCount)) {
+        m_filterThread->takeContact(maxCount);
+        Q_EMIT m_adaptor->contactsRemoved(maxCount, 1);
+    } else {
+        Q_EMIT countChanged(m_filterThread->count());
+    }
+    return true;
 }
 
 bool View::removeContact(ContactEntry *entry)
 {
-    if (!isOpen()) {
+    if (!filterDone(entry->individual()->id())) {
+        return false;
+    }
+
+    return removeContact(entry->individual()->id());
+}
+
+bool View::removeContact(const QString &id)
+{
+    int pos = m_filterThread->indexOf(id);
+    if (pos < 0) {
+        return false;
+    }
+
+    m_filterThread->takeContact(pos);
+    Q_EMIT m_adaptor->contactsRemoved(pos, 1);
+    Q_EMIT countChanged(m_filterThread->count());
+    return true;
+}
+
+bool View::updateContact(ContactEntry *entry)
+{
+    if (!filterDone(entry->individual()->id())) {
         return false;
     }
 
-    if (m_filterThread->removeContact(entry->individual()->contact())) {
-        Q_EMIT countChanged(m_filterThread->result().count());
-        return true;
+    int oldPos = m_filterThread->indexOf(entry->individual()->id());
+    if (oldPos < 0) {
+        // the contact may match the filter now
+        return appendContact(entry);
+    }
+
+    if (!m_filterThread->accept(entry)) {
+        return removeContact(entry->individual()->id());
+    }
+
+    // move the contact to the new position
+    ContactHandle oldHandle = m_filterThread->takeContact(oldPos);
+    int newPos = m_filterThread->insertContact(entry);
+    if (newPos == oldPos) {
+        // the contact details did not change if the version is the same
+        if (oldHandle.version != entry->individual()->version()) {
+            Q_EMIT m_adaptor->contactsUpdated(newPos, 1);
+        }
+    } else {
+        Q_EMIT m_adaptor->contactsRemoved(oldPos, 1);
+        if (newPos >= 0) {
+            Q_EMIT m_adaptor->contactsAdded(newPos, 1);
+        } else {
+            Q_EMIT countChanged(m_filterThread->count());
+        }
     }
-    return false;
+    return true;
 }
 
 QObject *View::adaptor() const
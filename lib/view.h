@@ -24,6 +24,8 @@
 
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
 #include <QtDBus/QtDBus>
 
 #include <QtContacts/QContactFilter>
@@ -33,6 +35,7 @@ namespace galera
 class ContactEntry;
 class ViewAdaptor;
 class ContactsMap;
+class ContactsSnapshot;
 class FilterThread;
 class SortContact;
 
@@ -42,7 +45,9 @@ class View : public QObject
     Q_PROPERTY(int count READ count NOTIFY countChanged)
 
 public:
-    View(const QString &clause, const QString &sort, int maxCount, bool showInvisible, const QStringList &sources, ContactsMap *allContacts, QObject *parent);
+    // views created before the contacts map is ready use the boot snapshot until setContactsMap() is called
+    View(const QString &clause, const QString &sort, int maxCount, bool showInvisible, const QStringList &sources,
+         ContactsMap *allContacts, const QSharedPointer<const ContactsSnapshot> &bootSnapshot, QObject *parent);
     ~View();
 
     static QString objectPath();
@@ -51,9 +56,15 @@ public:
     bool registerObject(QDBusConnection &connection);
     void unregisterObject(QDBusConnection &connection);
 
-    // contacts
+    // apply the contacts map changes on the view result
     bool appendContact(ContactEntry *entry);
     bool removeContact(ContactEntry *entry);
+    bool updateContact(ContactEntry *entry);
+    // run the filter again on the contacts map, the old result is removed from the view
+    void setContactsMap(ContactsMap *allContacts);
+
+    // reply the first page of the result and destroy the view, used by one-shot queries
+    void replyFirstPage(const QStringList &fields, int pageSize, const QDBusMessage &message);
 
     // Adaptor
     QString contactDetails(const QStringList &fields, const QString &id);
@@ -77,10 +88,20 @@ Q_SIGNALS:
 private:
     QStringList m_sources;
     FilterThread *m_filterThread;
+    ContactsMap *m_allContacts;
     ViewAdaptor *m_adaptor;
     QEventLoop *m_waiting;
+    bool m_oneShot;
+    // the filter is running again after setContactsMap()
+    bool m_reloading;
+    // ids of the contacts changed while the filter was running
+    QSet<QString> m_pendingChanges;
 
     void waitFilter();
+    void sendContactsDetails(const QStringList &fields, int startIndex, int pageSize, const QDBusMessage &message);
+    void sendReply(const QDBusMessage &message, const QStringList &vcards);
+    bool filterDone(const QString &id);
+    bool removeContact(const QString &id);
 };
 
 } //namespace
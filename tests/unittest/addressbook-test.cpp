@@ -240,6 +240,33 @@ private Q_SLOTS:
         QCOMPARE(addedContactSpy.count(), 0);
     }
 
+    void testCreateContacts()
+    {
+        // spy 'contactsAdded' signal
+        QSignalSpy addedContactSpy(m_serverIface, SIGNAL(contactsAdded(QStringList)));
+
+        // call create contacts with a valid and a invalid vcard
+        QDBusReply<QStringList> reply = m_serverIface->call("createContacts",
+                                                            QStringList() << m_basicVcard << "INVALID VCARD",
+                                                            "dummy-store");
+
+        // the result keeps the order of the vcards
+        QStringList vcards = reply.value();
+        QCOMPARE(vcards.count(), 2);
+        QVERIFY(!vcards[0].isEmpty());
+        QVERIFY(vcards[1].isEmpty());
+
+        // check if the contact was created with the correct fields
+        QtContacts::QContact newContact = galera::VCardParser::vcardToContact(vcards[0]);
+        QDBusReply<QStringList> reply2 = m_dummyIface->call("listContacts");
+        QCOMPARE(reply2.value().count(), 1);
+        QList<QtContacts::QContact> contactsCreated = galera::VCardParser::vcardToContactSync(reply2.value());
+        QCOMPARE(contactsCreated.count(), 1);
+        compareContact(contactsCreated[0], newContact);
+
+        QTRY_COMPARE(addedContactSpy.count(), 1);
+    }
+
     void testRemoveContact()
     {
         // create a basic contact
@@ -271,6 +298,40 @@ private Q_SLOTS:
         QCOMPARE(replyList.value().count(), 0);
     }
 
+    void testChangesSince()
+    {
+        // unknown revisions require a reset
+        QDBusMessage reply = m_serverIface->call("changesSince", QVariant::fromValue<qulonglong>(0));
+        QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+        QCOMPARE(reply.arguments().count(), 5);
+        QVERIFY(reply.arguments()[1].toBool());
+        qulonglong revision = reply.arguments()[0].toULongLong();
+
+        // create a basic contact
+        QSignalSpy addedContactSpy(m_serverIface, SIGNAL(contactsAdded(QStringList)));
+        QDBusReply<QString> replyAdd = m_serverIface->call("createContact", m_basicVcard, "dummy-store");
+        QTRY_COMPARE(addedContactSpy.count(), 1);
+        QString newContactId = galera::VCardParser::vcardToContact(replyAdd.value()).detail<QContactGuid>().guid();
+
+        reply = m_serverIface->call("changesSince", QVariant::fromValue<qulonglong>(revision));
+        QVERIFY(!reply.arguments()[1].toBool());
+        QVERIFY(reply.arguments()[0].toULongLong() > revision);
+        QCOMPARE(reply.arguments()[2].toStringList(), QStringList() << newContactId);
+        QVERIFY(reply.arguments()[3].toStringList().isEmpty());
+        QVERIFY(reply.arguments()[4].toStringList().isEmpty());
+
+        // the contact added and removed after the revision is not reported
+        QSignalSpy removedContactSpy(m_serverIface, SIGNAL(contactsRemoved(QStringList)));
+        QDBusReply<int> replyRemove = m_serverIface->call("removeContacts", QStringList() << newContactId);
+        QCOMPARE(replyRemove.value(), 1);
+        QTRY_COMPARE(removedContactSpy.count(), 1);
+
+        reply = m_serverIface->call("changesSince", QVariant::fromValue<qulonglong>(revision));
+        QVERIFY(!reply.arguments()[1].toBool());
+        QVERIFY(!reply.arguments()[2].toStringList().contains(newContactId));
+        QVERIFY(!reply.arguments()[4].toStringList().contains(newContactId));
+    }
+
     void testUpdateContact()
     {
         // create a basic contact
@@ -314,6 +375,74 @@ private Q_SLOTS:
         contactUpdatedResult = contacts[0];
         compareContact(contactUpdatedResult, contactUpdated);
     }
+
+    void testUpdateManyDetails()
+    {
+        // create a basic contact
+        QSignalSpy addedContactSpy(m_serverIface, SIGNAL(contactsAdded(QStringList)));
+        QDBusReply<QString> replyAdd = m_serverIface->call("createContact", m_basicVcard, "dummy-store");
+        QTRY_COMPARE(addedContactSpy.count(), 1);
+        QString vcard = replyAdd.value();
+
+        // change several details at once, the avatar change also changes the extended details
+        vcard = vcard.replace("8888888", "0000000");
+        vcard = vcard.replace("fulano_@ubuntu.com", "fulano@ubuntu.com");
+        vcard = vcard.replace("END:VCARD", "NICKNAME:Fulaninho\r\n"
+                                           "NOTE:Contact note\r\n"
+                                           "PHOTO;VALUE=URL:file:///tmp/avatar.png\r\n"
+                                           "URL:http://www.ubuntu.com\r\n"
+                                           "END:VCARD");
+        QtContacts::QContact contactUpdated = galera::VCardParser::vcardToContact(vcard);
+
+        QDBusReply<QStringList> replyUpdate = m_serverIface->call("updateContacts", QStringList() << vcard);
+        QCOMPARE(replyUpdate.value().size(), 1);
+
+        // check the contact stored on the backend
+        QDBusReply<QStringList> replyList = m_dummyIface->call("listContacts");
+        QCOMPARE(replyList.value().count(), 1);
+        QtContacts::QContact stored = galera::VCardParser::vcardToContact(replyList.value()[0]);
+        compareContact(stored, contactUpdated);
+        QCOMPARE(stored.detail<QtContacts::QContactNickname>().nickname(), QStringLiteral("Fulaninho"));
+        QCOMPARE(stored.detail<QtContacts::QContactNote>().note(), QStringLiteral("Contact note"));
+        QCOMPARE(stored.detail<QtContacts::QContactAvatar>().imageUrl(), QUrl("file:///tmp/avatar.png"));
+        QCOMPARE(stored.detail<QtContacts::QContactUrl>().url(), QStringLiteral("http://www.ubuntu.com"));
+    }
+
+    void testConcurrentUpdateContacts()
+    {
+        // create a basic contact
+        QSignalSpy addedContactSpy(m_serverIface, SIGNAL(contactsAdded(QStringList)));
+        QDBusReply<QString> replyAdd = m_serverIface->call("createContact", m_basicVcard, "dummy-store");
+        QTRY_COMPARE(addedContactSpy.count(), 1);
+        QString vcard = replyAdd.value();
+
+        // send two updates of the same contact without wait for the first reply
+        QString vcardA = QString(vcard).replace("8888888", "1111111");
+        QString vcardB = QString(vcard).replace("8888888", "2222222");
+        QDBusPendingCall callA = m_serverIface->asyncCall("updateContacts", QStringList() << vcardA);
+        QDBusPendingCall callB = m_serverIface->asyncCall("updateContacts",
+                                                          QStringList() << vcardB << "INVALID VCARD");
+
+        // each call receives its own result
+        QDBusPendingReply<QStringList> replyA(callA);
+        replyA.waitForFinished();
+        QCOMPARE(replyA.value().size(), 1);
+        compareContact(galera::VCardParser::vcardToContact(replyA.value()[0]),
+                       galera::VCardParser::vcardToContact(vcardA));
+
+        QDBusPendingReply<QStringList> replyB(callB);
+        replyB.waitForFinished();
+        QCOMPARE(replyB.value().size(), 2);
+        compareContact(galera::VCardParser::vcardToContact(replyB.value()[0]),
+                       galera::VCardParser::vcardToContact(vcardB));
+        QCOMPARE(replyB.value()[1], QStringLiteral("Contact not found!"));
+
+        // the last update wins
+        QDBusReply<QStringList> replyList = m_dummyIface->call("listContacts");
+        QCOMPARE(replyList.value().count(), 1);
+        compareContact(galera::VCardParser::vcardToContact(replyList.value()[0]),
+                       galera::VCardParser::vcardToContact(vcardB));
+    }
 };
 
 QTEST_MAIN(AddressBookTest)
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QtTest>
+#include <QDebug>
+
+#include "lib/change-journal.h"
+
+using namespace galera;
+
+class ChangeJournalTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testChangesSince()
+    {
+        ChangeJournal journal(10);
+        quint64 start = journal.revision();
+
+        journal.append(ChangeJournal::Added, QSet<QString>() << "a");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "b");
+        journal.append(ChangeJournal::Removed, QSet<QString>() << "c");
+        QCOMPARE(journal.revision(), start + 3);
+
+        QStringList added, updated, removed;
+        QVERIFY(journal.changesSince(start, &added, &updated, &removed));
+        QCOMPARE(added, QStringList() << "a");
+        QCOMPARE(updated, QStringList() << "b");
+        QCOMPARE(removed, QStringList() << "c");
+
+        // only the changes after the revision
+        added.clear(); updated.clear(); removed.clear();
+        QVERIFY(journal.changesSince(start + 2, &added, &updated, &removed));
+        QVERIFY(added.isEmpty());
+        QVERIFY(updated.isEmpty());
+        QCOMPARE(removed, QStringList() << "c");
+
+        // nothing changed
+        added.clear(); updated.clear(); removed.clear();
+        QVERIFY(journal.changesSince(journal.revision(), &added, &updated, &removed));
+        QVERIFY(added.isEmpty() && updated.isEmpty() && removed.isEmpty());
+
+        // unknown revisions
+        QVERIFY(!journal.changesSince(journal.revision() + 1, &added, &updated, &removed));
+        QVERIFY(!journal.changesSince(0, &added, &updated, &removed));
+    }
+
+    void testMergeChanges()
+    {
+        ChangeJournal journal(10);
+        quint64 start = journal.revision();
+
+        // added and updated is reported as added
+        journal.append(ChangeJournal::Added, QSet<QString>() << "a");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "a");
+        // added and removed is not reported
+        journal.append(ChangeJournal::Added, QSet<QString>() << "b");
+        journal.append(ChangeJournal::Removed, QSet<QString>() << "b");
+        // removed and added again is reported as updated
+        journal.append(ChangeJournal::Removed, QSet<QString>() << "c");
+        journal.append(ChangeJournal::Added, QSet<QString>() << "c");
+        // updated and removed is reported as removed
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "d");
+        journal.append(ChangeJournal::Removed, QSet<QString>() << "d");
+
+        QStringList added, updated, removed;
+        QVERIFY(journal.changesSince(start, &added, &updated, &removed));
+        QCOMPARE(added, QStringList() << "a");
+        QCOMPARE(updated, QStringList() << "c");
+        QCOMPARE(removed, QStringList() << "d");
+    }
+
+    void testOverflow()
+    {
+        ChangeJournal journal(3);
+        quint64 start = journal.revision();
+
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "a");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "b");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "c");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "d");
+
+        // the first change was discarded
+        QStringList added, updated, removed;
+        QVERIFY(!journal.changesSince(start, &added, &updated, &removed));
+        QVERIFY(journal.changesSince(start + 1, &added, &updated, &removed));
+        QCOMPARE(updated, QStringList() << "b" << "c" << "d");
+
+        // all clients must reset after the journal reset
+        journal.reset();
+        QVERIFY(!journal.changesSince(start + 4, &added, &updated, &removed));
+        updated.clear();
+        QVERIFY(journal.changesSince(journal.revision(), &added, &updated, &removed));
+        QVERIFY(updated.isEmpty());
+    }
+
+    void testEpoch()
+    {
+        // two journals simulate two instances of the service
+        ChangeJournal previous(10);
+        ChangeJournal journal(10);
+        QVERIFY((previous.revision() >> 32) != (journal.revision() >> 32));
+
+        // the journals have the same number of changes
+        previous.append(ChangeJournal::Updated, QSet<QString>() << "a");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "b");
+        journal.append(ChangeJournal::Updated, QSet<QString>() << "c");
+        previous.append(ChangeJournal::Updated, QSet<QString>() << "d");
+
+        // revisions from the other instance are rejected even if the counter is valid
+        QStringList added, updated, removed;
+        QVERIFY(!journal.changesSince(previous.revision(), &added, &updated, &removed));
+        QVERIFY(!journal.changesSince(previous.revision() - 1, &added, &updated, &removed));
+        QVERIFY(!previous.changesSince(journal.revision() - 2, &added, &updated, &removed));
+        QVERIFY(updated.isEmpty());
+
+        QVERIFY(journal.changesSince(journal.revision() - 1, &added, &updated, &removed));
+        QCOMPARE(updated, QStringList() << "c");
+
+        // the reset starts a new epoch
+        quint64 revision = journal.revision();
+        journal.reset();
+        QVERIFY((journal.revision() >> 32) != (revision >> 32));
+        QVERIFY(!journal.changesSince(revision, &added, &updated, &removed));
+    }
+};
+
+QTEST_MAIN(ChangeJournalTest)
+
+#include "change-journal-test.moc"
@@ -24,6 +24,7 @@
 #include <QtContacts>
 
 #include "common/filter.h"
+#include "common/compiled-filter.h"
 
 using namespace QtContacts;
 using namespace galera;
@@ -238,15 +239,21 @@ private Q_SLOTS:
         p.setNumber(phoneNumber);
         c.saveDetail(&p);
 
+        // numbers already parsed, as cached by the server for each contact
+        QList<ParsedPhoneNumber> numbers;
+        numbers << ParsedPhoneNumber(phoneNumber);
+
         // if they are the same phone number
         QContactDetailFilter f = QContactPhoneNumber::match(query);
         Filter myFilter(f);
         QCOMPARE(myFilter.test(c), match);
+        QCOMPARE(myFilter.test(c, QDateTime(), &numbers), match);
 
         // if the phoneNumber contains query
         f.setMatchFlags(QContactFilter::MatchPhoneNumber | QContactFilter::MatchContains);
         myFilter = Filter(f);
         QCOMPARE(myFilter.test(c), matchContains);
+        QCOMPARE(myFilter.test(c, QDateTime(), &numbers), matchContains);
 
         // if the phoneNumber starts with query
         f.setMatchFlags(QContactFilter::MatchPhoneNumber | QContactFilter::MatchStartsWith);
@@ -347,6 +354,49 @@ private Q_SLOTS:
         // filter again with favorites and removed contacts
         QVERIFY(removedAndFavoriteFilter.test(c, QDateTime::currentDateTime()));
     }
+
+    void testCompiledFilter()
+    {
+        QContact c;
+        QContactName name;
+        name.setFirstName("Foo");
+        name.setLastName("Bar");
+        c.saveDetail(&name);
+
+        QContactPhoneNumber phone;
+        phone.setNumber("(81) 8704-2155");
+        c.saveDetail(&phone);
+
+        QContactDetailFilter firstNameFilter;
+        firstNameFilter.setDetailType(QContactName::Type, QContactName::FieldFirstName);
+        firstNameFilter.setValue("fo");
+        firstNameFilter.setMatchFlags(QContactFilter::MatchStartsWith);
+
+        QContactDetailFilter lastNameFilter;
+        lastNameFilter.setDetailType(QContactName::Type, QContactName::FieldLastName);
+        lastNameFilter.setValue("Baz");
+        lastNameFilter.setMatchFlags(QContactFilter::MatchContains | QContactFilter::MatchCaseSensitive);
+
+        QContactDetailFilter favFilter;
+        favFilter.setDetailType(QContactFavorite::Type, QContactFavorite::FieldFavorite);
+        favFilter.setValue(true);
+
+        QContactFilter filter = (firstNameFilter & (lastNameFilter | QContactPhoneNumber::match("87042155"))) | favFilter;
+
+        // the tree is flattened into one instruction for each node
+        CompiledFilter program(filter);
+        QCOMPARE(program.size(), 7);
+        QVERIFY(program.test(c));
+
+        firstNameFilter.setMatchFlags(QContactFilter::MatchStartsWith | QContactFilter::MatchCaseSensitive);
+        filter = (firstNameFilter & (lastNameFilter | QContactPhoneNumber::match("87042155"))) | favFilter;
+        QVERIFY(!CompiledFilter(filter).test(c));
+
+        // empty intersections and unions does not match
+        QVERIFY(!CompiledFilter(QContactIntersectionFilter()).test(c));
+        QVERIFY(!CompiledFilter(QContactUnionFilter()).test(c));
+        QVERIFY(CompiledFilter(QContactFilter()).test(c));
+    }
 };
 
 QTEST_MAIN(ClauseParseTest)
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This file is part of contact-service-app.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QtTest>
+#include <QDebug>
+
+#include <QtContacts>
+
+#include "common/sort-clause.h"
+#include "lib/contact-less-than.h"
+#include "lib/contacts-map.h"
+
+#include <algorithm>
+
+using namespace QtContacts;
+using namespace galera;
+
+#define BENCHMARK_CONTACTS 2000
+
+class ContactSortBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QList<QContact> m_contacts;
+
+    static QContact createContact(int index)
+    {
+        QContact contact;
+
+        QContactDisplayLabel label;
+        label.setLabel(QString("Contact %1 %2").arg(qrand() % 1000).arg(index));
+        contact.saveDetail(&label);
+
+        // leave some contacts without tag to exercise the blank policy
+        if (index % 3) {
+            QContactTag tag;
+            tag.setTag(QString(QChar('A' + (qrand() % 26))));
+            contact.saveDetail(&tag);
+        }
+
+        QContactName name;
+        name.setFirstName(QString("First%1").arg(qrand() % 500));
+        name.setLastName(QString("Last%1").arg(index));
+        contact.saveDetail(&name);
+        return contact;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qsrand(42);
+        for (int i = 0; i < BENCHMARK_CONTACTS; i++) {
+            m_contacts << createContact(i);
+        }
+    }
+
+    void benchmarkSortedInsert_data()
+    {
+        QTest::addColumn<bool>("specialized");
+
+        QTest::newRow("generic") << false;
+        QTest::newRow("specialized") << true;
+    }
+
+    void benchmarkSortedInsert()
+    {
+        QFETCH(bool, specialized);
+        SortClause clause = ContactsMap::defaultSort();
+
+        QList<ContactSortKey> keys;
+        Q_FOREACH(const QContact &contact, m_contacts) {
+            keys << ContactSortKey(contact, clause);
+        }
+
+        QBENCHMARK {
+            QList<const ContactSortKey*> sorted;
+            if (specialized) {
+                ContactSortComparator comparator(clause);
+                Q_FOREACH(const ContactSortKey &key, keys) {
+                    sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), &key,
+                                                   [&comparator](const ContactSortKey *a, const ContactSortKey *b) {
+                                                       return (comparator.compare(*a, *b) < 0);
+                                                   }), &key);
+                }
+            } else {
+                Q_FOREACH(const ContactSortKey &key, keys) {
+                    sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), &key,
+                                                   [](const ContactSortKey *a, const ContactSortKey *b) {
+                                                       return (a->compare(*b) < 0);
+                                                   }), &key);
+                }
+            }
+            QCOMPARE(sorted.size(), keys.size());
+        }
+    }
+
+    void benchmarkFullSort_data()
+    {
+        QTest::addColumn<bool>("specialized");
+
+        QTest::newRow("engine") << false;
+        QTest::newRow("specialized") << true;
+    }
+
+    void benchmarkFullSort()
+    {
+        QFETCH(bool, specialized);
+        SortClause clause = ContactsMap::defaultSort();
+
+        QBENCHMARK {
+            QList<QContact> contacts(m_contacts);
+            if (specialized) {
+                ContactLessThan::sort(&contacts, clause);
+            } else {
+                QList<QContactSortOrder> sortOrders = clause.toContactSortOrder();
+                std::stable_sort(contacts.begin(), contacts.end(),
+                                 [&sortOrders](const QContact &a, const QContact &b) {
+                                     return (QContactManagerEngine::compareContact(a, b, sortOrders) < 0);
+                                 });
+            }
+            QCOMPARE(contacts.size(), m_contacts.size());
+        }
+    }
+};
+
+QTEST_MAIN(ContactSortBenchmark)
+
+#include "contact-sort-benchmark.moc"
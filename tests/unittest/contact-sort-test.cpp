@@ -60,6 +60,35 @@ private:
         return galera::VCardParser::contactToVcardSync(QList<QContact>() << contact)[0];
     }
 
+    QDBusInterface *openView(int maxCount)
+    {
+        QDBusMessage result = m_serverIface->call("query", "", "", maxCount, false, QStringList());
+        QDBusObjectPath viewObjectPath = result.arguments()[0].value<QDBusObjectPath>();
+        return new QDBusInterface(m_serverIface->service(),
+                                  viewObjectPath.path(),
+                                  CPIM_ADDRESSBOOK_VIEW_IFACE_NAME);
+    }
+
+    // display labels of the view contacts, it waits for the view filter
+    QStringList viewLabels(QDBusInterface *view)
+    {
+        QDBusReply<QStringList> reply = view->call("contactsDetails", QStringList(), 0, 100);
+        QStringList labels;
+        Q_FOREACH(const QContact &contact, galera::VCardParser::vcardToContactSync(reply.value())) {
+            labels << contact.detail<QtContacts::QContactDisplayLabel>().label();
+        }
+        return labels;
+    }
+
+    void compareSignal(QSignalSpy &spy, int pos, int length)
+    {
+        QTRY_VERIFY(spy.count() > 0);
+        QList<QVariant> args = spy.takeFirst();
+        QCOMPARE(args.count(), 2);
+        QCOMPARE(args[0].toInt(), pos);
+        QCOMPARE(args[1].toInt(), length);
+    }
+
 private Q_SLOTS:
     void initTestCase()
     {
@@ -202,6 +231,73 @@ private Q_SLOTS:
         QCOMPARE(contactsCreated[4].detail<QtContacts::QContactDisplayLabel>().label(), QStringLiteral("(999) 999-9999"));
         QCOMPARE(contactsCreated[5].detail<QtContacts::QContactDisplayLabel>().label(), QStringLiteral("555-5555"));
     }
+
+    /*
+     * Test the changes applied on the open views without run the filter again
+     */
+    void testViewChanges()
+    {
+        QDBusReply<QString> replyBaz = m_serverIface->call("createContact", createContact("Baz Quux"), "dummy-store");
+        QDBusReply<QString> replyFoo = m_serverIface->call("createContact", createContact("Foo Bar"), "dummy-store");
+
+        QDBusInterface *view = openView(0);
+        QCOMPARE(viewLabels(view), QStringList() << "Baz Quux" << "Foo Bar");
+        QCOMPARE(view->property("count").toInt(), 2);
+
+        QSignalSpy addedSpy(view, SIGNAL(contactsAdded(int, int)));
+        QSignalSpy removedSpy(view, SIGNAL(contactsRemoved(int, int)));
+        QSignalSpy updatedSpy(view, SIGNAL(contactsUpdated(int, int)));
+
+        // new contact on the sorted position
+        QDBusReply<QString> replyRenato = m_serverIface->call("createContact", createContact("Renato Araujo"),
+                                                              "dummy-store");
+        compareSignal(addedSpy, 2, 1);
+        QTRY_COMPARE(view->property("count").toInt(), 3);
+
+        // the new name moves the contact to the end of the view
+        QString vcard = replyBaz.value().replace("Baz", "Zed");
+        m_serverIface->call("updateContacts", QStringList() << vcard);
+        compareSignal(removedSpy, 0, 1);
+        compareSignal(addedSpy, 2, 1);
+        QCOMPARE(viewLabels(view), QStringList() << "Foo Bar" << "Renato Araujo" << "Zed Quux");
+
+        // the contact keeps the position
+        removedSpy.clear();
+        addedSpy.clear();
+        updatedSpy.clear();
+        vcard = replyFoo.value().replace("END:VCARD", "NOTE:Foo note\r\nEND:VCARD");
+        m_serverIface->call("updateContacts", QStringList() << vcard);
+        compareSignal(updatedSpy, 0, 1);
+        QVERIFY(removedSpy.isEmpty());
+        QVERIFY(addedSpy.isEmpty());
+
+        // removed contact
+        QString renatoId = galera::VCardParser::vcardToContact(replyRenato.value()).detail<QContactGuid>().guid();
+        m_serverIface->call("removeContacts", QStringList() << renatoId);
+        compareSignal(removedSpy, 1, 1);
+        QTRY_COMPARE(view->property("count").toInt(), 2);
+        QCOMPARE(viewLabels(view), QStringList() << "Foo Bar" << "Zed Quux");
+
+        // the views with maxCount remove the last contact when a new one is added before it
+        QDBusInterface *limitedView = openView(2);
+        QCOMPARE(viewLabels(limitedView), QStringList() << "Foo Bar" << "Zed Quux");
+        QSignalSpy limitedAddedSpy(limitedView, SIGNAL(contactsAdded(int, int)));
+        QSignalSpy limitedRemovedSpy(limitedView, SIGNAL(contactsRemoved(int, int)));
+        m_serverIface->call("createContact", createContact("Aaron Alves"), "dummy-store");
+        compareSignal(limitedAddedSpy, 0, 1);
+        compareSignal(limitedRemovedSpy, 2, 1);
+        QCOMPARE(limitedView->property("count").toInt(), 2);
+        QCOMPARE(viewLabels(limitedView), QStringList() << "Aaron Alves" << "Foo Bar");
+        delete limitedView;
+
+        // the changes done while the filter runs are applied when it finishes
+        QDBusInterface *newView = openView(0);
+        m_serverIface->call("createContact", createContact("Maria Silva"), "dummy-store");
+        QTRY_COMPARE(newView->property("count").toInt(), 4);
+        QCOMPARE(viewLabels(newView), QStringList() << "Aaron Alves" << "Foo Bar" << "Maria Silva" << "Zed Quux");
+        delete newView;
+        delete view;
+    }
 };
 
 QTEST_MAIN(ContactSortTest)
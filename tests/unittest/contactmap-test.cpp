@@ -21,8 +21,14 @@
 #include "scoped-loop.h"
 
 #include "lib/contacts-map.h"
+#include "lib/contacts-snapshot-file.h"
+#include "lib/contact-less-than.h"
+#include "lib/filter-planner.h"
+#include "lib/filter-scan.h"
 #include "lib/qindividual.h"
 
+#include "common/vcard-parser.h"
+
 #include <QObject>
 #include <QtTest>
 #include <QDebug>
@@ -90,6 +96,33 @@ private:
         m_dummy->createContact(contact);
     }
 
+    // contacts with display label, tag and name used to check the sort functions
+    static QList<QtContacts::QContact> sortContacts(int count)
+    {
+        QList<QtContacts::QContact> contacts;
+        for (int i = 0; i < count; i++) {
+            QtContacts::QContact contact;
+
+            QtContacts::QContactDisplayLabel label;
+            label.setLabel(QString("Contact %1 %2").arg((i * 7919) % 1000).arg(i));
+            contact.saveDetail(&label);
+
+            // leave some contacts without tag to exercise the blank policy
+            if (i % 3) {
+                QtContacts::QContactTag tag;
+                tag.setTag(QString(QChar('A' + ((i * 31) % 26))));
+                contact.saveDetail(&tag);
+            }
+
+            QtContacts::QContactName name;
+            name.setFirstName(QString("First%1").arg((i * 13) % 50));
+            name.setLastName(QString("Last%1").arg(i));
+            contact.saveDetail(&name);
+            contacts << contact;
+        }
+        return contacts;
+    }
+
     QStringList allPhones()
     {
         QStringList phones;
@@ -164,6 +197,323 @@ private Q_SLOTS:
         }
     }
 
+    void testPosition()
+    {
+        QList<galera::ContactEntry*> entries = m_map.values();
+        for (int i = 0; i < entries.size(); i++) {
+            QCOMPARE(m_map.indexOf(entries[i]), i);
+            QCOMPARE(m_map.at(i), entries[i]);
+        }
+
+        QCOMPARE(m_map.values(1, 2), entries.mid(1, 2));
+        QCOMPARE(m_map.values(entries.size() - 1, 10), entries.mid(entries.size() - 1));
+        QVERIFY(m_map.at(entries.size()) == 0);
+    }
+
+    void testBulkLoad()
+    {
+        galera::ContactsMap map;
+        map.beginBulkLoad();
+        QVERIFY(map.isBulkLoading());
+
+        // insert the contacts in the reverse order
+        QList<galera::ContactEntry*> entries = m_map.values();
+        for (int i = entries.size() - 1; i >= 0; i--) {
+            FolksIndividual *individual = entries[i]->individual()->individual();
+            map.insert(new galera::ContactEntry(new galera::QIndividual(individual, m_dummy->aggregator())));
+        }
+
+        // the indexes are filled when the load ends
+        QString phone = entries[0]->individual()->contact().detail<QtContacts::QContactPhoneNumber>().number();
+        QVERIFY(map.valueByPhone(phone).isEmpty());
+
+        map.endBulkLoad();
+        QVERIFY(!map.isBulkLoading());
+        QCOMPARE(map.size(), entries.size());
+        QCOMPARE(map.keys().toSet(), m_map.keys().toSet());
+        for (int i = 0; i < entries.size(); i++) {
+            QCOMPARE(map.at(i)->individual()->id(), entries[i]->individual()->id());
+        }
+        QCOMPARE(map.valueByPhone(phone).size(), 1);
+        QCOMPARE(map.valueByPhone(phone)[0]->individual()->id(), entries[0]->individual()->id());
+        map.clear();
+    }
+
+    void testSortKey()
+    {
+        QList<galera::ContactEntry*> entries = m_map.values();
+        galera::SortClause sort = m_map.sort();
+        for (int i = 1; i < entries.size(); i++) {
+            const galera::ContactSortKey &keyA = entries[i - 1]->sortKey(sort);
+            const galera::ContactSortKey &keyB = entries[i]->sortKey(sort);
+            int expected = QtContacts::QContactManagerEngine::compareContact(entries[i - 1]->individual()->contact(),
+                                                                             entries[i]->individual()->contact(),
+                                                                             sort.toContactSortOrder());
+            QCOMPARE(qBound(-1, keyA.compare(keyB), 1), qBound(-1, expected, 1));
+            QVERIFY(keyA.compare(keyB) <= 0);
+        }
+    }
+
+    void testSortKeyPerClause()
+    {
+        galera::ContactEntry *entry = m_map.values().first();
+        galera::SortClause sort = m_map.sort();
+        const galera::ContactSortKey *mapKey = &entry->sortKey(sort);
+
+        // the keys of the views sorted differently do not replace the map key
+        QStringList viewSorts;
+        viewSorts << "FIRST_NAME" << "LAST_NAME DESC" << "NICKNAME" << "PHONE" << "EMAIL";
+        Q_FOREACH(const QString &viewSort, viewSorts) {
+            const galera::ContactSortKey &key = entry->sortKey(galera::SortClause(viewSort));
+            QVERIFY(key.isValidFor(galera::SortClause(viewSort)));
+            QVERIFY(&entry->sortKey(sort) == mapKey);
+        }
+    }
+
+    void testComparatorMatchesEngine_data()
+    {
+        QTest::addColumn<QString>("sort");
+
+        QTest::newRow("default") << QString();
+        QTest::newRow("single field") << QString("FIRST_NAME");
+        QTest::newRow("single field desc") << QString("LAST_NAME DESC");
+        QTest::newRow("multiple fields") << QString("FIRST_NAME DESC, LAST_NAME");
+        QTest::newRow("non string field") << QString("BIRTHDAY, FULL_NAME");
+    }
+
+    void testComparatorMatchesEngine()
+    {
+        QFETCH(QString, sort);
+        galera::SortClause clause = sort.isEmpty() ? galera::ContactsMap::defaultSort() : galera::SortClause(sort);
+        galera::ContactSortComparator comparator(clause);
+
+        QList<QtContacts::QContact> contacts = sortContacts(200);
+        for (int i = 1; i < contacts.size(); i++) {
+            const QtContacts::QContact &contactA = contacts.at(i - 1);
+            const QtContacts::QContact &contactB = contacts.at(i);
+            int expected = QtContacts::QContactManagerEngine::compareContact(contactA, contactB,
+                                                                             clause.toContactSortOrder());
+            int result = comparator.compare(galera::ContactSortKey(contactA, clause),
+                                            galera::ContactSortKey(contactB, clause));
+            QCOMPARE(qBound(-1, result, 1), qBound(-1, expected, 1));
+        }
+    }
+
+    void testTopSort_data()
+    {
+        QTest::addColumn<int>("maxCount");
+
+        QTest::newRow("small") << 10;
+        QTest::newRow("large") << 100;
+        QTest::newRow("all") << 200;
+    }
+
+    void testTopSort()
+    {
+        QFETCH(int, maxCount);
+        galera::SortClause clause = galera::ContactsMap::defaultSort();
+        QList<QtContacts::QContact> contacts = sortContacts(200);
+
+        QList<QtContacts::QContact> sorted(contacts);
+        galera::ContactLessThan::sort(&sorted, clause);
+
+        QList<QtContacts::QContact> top(contacts);
+        galera::ContactLessThan::sort(&top, clause, maxCount);
+        QCOMPARE(top, sorted.mid(0, maxCount));
+    }
+
+    void testFilterPlanner()
+    {
+        using namespace QtContacts;
+
+        QContactDetailFilter emailFilter1;
+        emailFilter1.setDetailType(QContactEmailAddress::Type, QContactEmailAddress::FieldEmailAddress);
+        emailFilter1.setValue("Fulano_1@ubuntu.com");
+        emailFilter1.setMatchFlags(QContactFilter::MatchFixedString);
+
+        QContactDetailFilter emailFilter2(emailFilter1);
+        emailFilter2.setValue("fulano_2@ubuntu.com");
+
+        QContactDetailFilter nameFilter;
+        nameFilter.setDetailType(QContactName::Type, QContactName::FieldFirstName);
+        nameFilter.setValue("ful");
+        nameFilter.setMatchFlags(QContactFilter::MatchStartsWith);
+
+        // single index lookup
+        galera::FilterPlanner planner(&m_map);
+        QVERIFY(planner.plan(galera::Filter(emailFilter1)));
+        QCOMPARE(planner.cost(), 1);
+        QCOMPARE(planner.candidates().size(), 1);
+
+        // union merges the lookups of all terms
+        QVERIFY(planner.plan(galera::Filter(emailFilter1 | emailFilter2)));
+        QCOMPARE(planner.cost(), 2);
+        QList<galera::ContactEntry*> candidates = planner.candidates();
+        QCOMPARE(candidates.size(), 2);
+        QVERIFY(m_map.indexOf(candidates.at(0)) < m_map.indexOf(candidates.at(1)));
+
+        // intersection uses the most selective term
+        QVERIFY(planner.plan(galera::Filter(nameFilter & emailFilter2)));
+        QCOMPARE(planner.cost(), 1);
+
+        // the name index would return all contacts
+        QVERIFY(!planner.plan(galera::Filter(nameFilter)));
+
+        // contains can not be solved by the indexes
+        nameFilter.setMatchFlags(QContactFilter::MatchContains);
+        QVERIFY(!planner.plan(galera::Filter(nameFilter | emailFilter1)));
+        QCOMPARE(planner.positions().size(), m_map.size());
+    }
+
+    void testNameIndexWithManyDetails()
+    {
+        using namespace QtContacts;
+
+        // aggregated contacts can have one nickname for each persona
+        QContact contact;
+        QContactNickname nickname;
+        nickname.setNickname("Alpha");
+        contact.saveDetail(&nickname);
+        QContactNickname otherNickname;
+        otherNickname.setNickname("Zeta");
+        contact.saveDetail(&otherNickname);
+        QCOMPARE(contact.details<QContactNickname>().size(), 2);
+
+        QContactDetailFilter filter;
+        filter.setDetailType(QContactNickname::Type, QContactNickname::FieldNickname);
+        filter.setValue("Zeta");
+        filter.setMatchFlags(QContactFilter::MatchStartsWith);
+        QVERIFY(galera::Filter(filter).test(contact));
+
+        // the contact must be returned by the name index lookup used for the filter
+        QVector<QChar> keys = galera::ContactsMap::nameKeys(contact);
+        QVERIFY(keys.contains(QChar('a')));
+        QVERIFY(keys.contains(QChar('z')));
+    }
+
+    void testSnapshot()
+    {
+        QSharedPointer<const galera::ContactsSnapshot> snapshot = m_map.snapshot();
+        QCOMPARE(snapshot->entries.size(), m_map.size());
+        for (int i = 0; i < m_map.size(); i++) {
+            QCOMPARE(snapshot->entries.at(i).contact, m_map.at(i)->individual()->contact());
+        }
+
+        // the snapshot is reused while the map does not change
+        QVERIFY(m_map.snapshot() == snapshot);
+
+        // removed entries stay on the old snapshot
+        galera::ContactEntry *entry = m_map.take(randomIndividual());
+        QSharedPointer<const galera::ContactsSnapshot> newSnapshot = m_map.snapshot();
+        QVERIFY(newSnapshot != snapshot);
+        QCOMPARE(newSnapshot->entries.size(), m_map.size());
+        QCOMPARE(snapshot->entries.size(), m_map.size() + 1);
+
+        // the unchanged entries are reused from the previous snapshot
+        for (int i = 0; i < newSnapshot->entries.size(); i++) {
+            const galera::ContactSnapshotEntry &e = newSnapshot->entries.at(i);
+            QCOMPARE(e.version, m_map.value(e.id)->individual()->version());
+            QCOMPARE(e.contact, m_map.value(e.id)->individual()->contact());
+        }
+
+        m_map.insert(entry);
+        QCOMPARE(m_map.snapshot()->entries.size(), snapshot->entries.size());
+    }
+
+    void testSnapshotFile()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.path() + "/contacts.snapshot";
+
+        QSharedPointer<const galera::ContactsSnapshot> snapshot = m_map.snapshot();
+        QVERIFY(galera::ContactsSnapshotFile::save(path, *snapshot));
+
+        // the entries are loaded in the map order
+        QSharedPointer<const galera::ContactsSnapshot> loaded = galera::ContactsSnapshotFile::load(path);
+        QVERIFY(!loaded.isNull());
+        QCOMPARE(loaded->sortClause.toString(), snapshot->sortClause.toString());
+        QCOMPARE(loaded->entries.size(), snapshot->entries.size());
+        for (int i = 0; i < snapshot->entries.size(); i++) {
+            const galera::ContactSnapshotEntry &expected = snapshot->entries.at(i);
+            const galera::ContactSnapshotEntry &entry = loaded->entries.at(i);
+            QCOMPARE(entry.id, expected.id);
+            QCOMPARE(entry.visible, expected.visible);
+            QCOMPARE(entry.phoneNumbers.size(), expected.phoneNumbers.size());
+            for (int p = 0; p < entry.phoneNumbers.size(); p++) {
+                QCOMPARE(entry.phoneNumbers.at(p).number(), expected.phoneNumbers.at(p).number());
+            }
+            QCOMPARE(entry.contact.detail<QtContacts::QContactName>().firstName(),
+                     expected.contact.detail<QtContacts::QContactName>().firstName());
+        }
+
+        // invalid files are ignored
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("INVALID SNAPSHOT");
+        file.close();
+        QVERIFY(galera::ContactsSnapshotFile::load(path).isNull());
+        QVERIFY(galera::ContactsSnapshotFile::load(dir.path() + "/missing").isNull());
+    }
+
+    void testFilterScan()
+    {
+        using namespace QtContacts;
+
+        QContactDetailFilter nameFilter;
+        nameFilter.setDetailType(QContactName::Type, QContactName::FieldFirstName);
+        nameFilter.setValue("ulano_");
+        nameFilter.setMatchFlags(QContactFilter::MatchContains);
+
+        // repeat the contacts to use more than one chunk
+        QList<int> positions;
+        while (positions.size() < (galera::FilterScan::ChunkSize * 3)) {
+            for (int i = 0; i < m_map.size(); i++) {
+                positions << i;
+            }
+        }
+
+        QSharedPointer<galera::FilterScan> scan(new galera::FilterScan(galera::Filter(nameFilter),
+                                                                       m_map.snapshot(),
+                                                                       positions,
+                                                                       true, 0));
+        galera::FilterScan::exec(scan);
+        QVERIFY(!scan->isCanceled());
+        QCOMPARE(scan->result(), positions);
+
+        // the result keeps the positions order and stops on maxCount
+        scan = QSharedPointer<galera::FilterScan>(new galera::FilterScan(galera::Filter(nameFilter),
+                                                                         m_map.snapshot(),
+                                                                         positions,
+                                                                         true, 10));
+        galera::FilterScan::exec(scan);
+        QCOMPARE(scan->result(), positions.mid(0, 10));
+    }
+
+    void testVcardCache()
+    {
+        using namespace QtContacts;
+
+        galera::QIndividual *individual = m_map.value(randomIndividual())->individual();
+        QList<QContactDetail::DetailType> fields;
+        fields << QContactDetail::TypeName << QContactDetail::TypeEmailAddress;
+
+        QVERIFY(individual->cachedVcard(fields).isEmpty());
+        QString vcard = individual->vcard(fields);
+        QCOMPARE(vcard, galera::VCardParser::contactToVcard(individual->copy(fields)));
+        QCOMPARE(individual->cachedVcard(fields), vcard);
+
+        // the field order does not matter
+        QList<QContactDetail::DetailType> reversed;
+        reversed << QContactDetail::TypeEmailAddress << QContactDetail::TypeName;
+        QCOMPARE(individual->cachedVcard(reversed), vcard);
+        QVERIFY(individual->cachedVcard(QList<QContactDetail::DetailType>()).isEmpty());
+
+        // vCards exported from an old version are not stored
+        individual->setCachedVcard(QList<QContactDetail::DetailType>(), individual->version() + 1, vcard);
+        QVERIFY(individual->cachedVcard(QList<QContactDetail::DetailType>()).isEmpty());
+    }
+
     void testTakeIndividual()
     {
         FolksIndividual *individual = folks_individual_new(0);
@@ -177,6 +527,12 @@ private Q_SLOTS:
         galera::ContactEntry *entry = m_map.take(individual);
         QVERIFY(entry->individual()->individual() == individual);
 
+        // the phone index should not point to the removed entry
+        Q_FOREACH(const QtContacts::QContactPhoneNumber &phone,
+                  entry->individual()->contact().details<QtContacts::QContactPhoneNumber>()) {
+            QVERIFY(!m_map.valueByPhone(phone.number()).contains(entry));
+        }
+
         //put it back
         m_map.insert(entry);
     }
@@ -238,6 +594,40 @@ private Q_SLOTS:
         QList<galera::ContactEntry*> entries = m_map.valueByPhone(query);
         QCOMPARE(entries.size(), numberOfMatches);
     }
+
+    void testEqualContactsOrder()
+    {
+        // the contacts created by testLookupByPhone_data have the same name
+        QList<galera::QIndividual*> individuals = m_dummy->individuals();
+        QStringList arrival;
+        galera::ContactsMap map;
+        galera::ContactsMap bulkMap;
+        bulkMap.beginBulkLoad();
+        Q_FOREACH(galera::QIndividual *i, individuals) {
+            map.insert(new galera::ContactEntry(new galera::QIndividual(i->individual(), m_dummy->aggregator())));
+            bulkMap.insert(new galera::ContactEntry(new galera::QIndividual(i->individual(), m_dummy->aggregator())));
+            arrival << i->id();
+        }
+        bulkMap.endBulkLoad();
+
+        // equal contacts keep the arrival order on the tree insert and on the bulk load sort
+        galera::ContactSortComparator comparator(map.sort());
+        int equalContacts = 0;
+        QCOMPARE(map.size(), individuals.size());
+        QCOMPARE(bulkMap.size(), individuals.size());
+        for (int i = 0; i < map.size(); i++) {
+            QCOMPARE(bulkMap.at(i)->individual()->id(), map.at(i)->individual()->id());
+            if ((i > 0) &&
+                (comparator.compare(map.at(i - 1)->sortKey(map.sort()), map.at(i)->sortKey(map.sort())) == 0)) {
+                QVERIFY(arrival.indexOf(map.at(i - 1)->individual()->id()) <
+                        arrival.indexOf(map.at(i)->individual()->id()));
+                equalContacts++;
+            }
+        }
+        QVERIFY(equalContacts > 0);
+        map.clear();
+        bulkMap.clear();
+    }
 };
 
 QTEST_MAIN(ContactMapTest)
@@ -100,6 +100,49 @@ private Q_SLOTS:
         // check if the signal did not fire
         QCOMPARE(spyContactAdded.count(), 0);
     }
+
+    /*
+     * Test fetch by id requests started together
+     */
+    void testConcurrentFetchByIdRequests()
+    {
+        QContactManager manager("galera");
+
+        QList<QContactId> ids;
+        Q_FOREACH(const QString &firstName, QStringList() << "First" << "Second") {
+            QContact contact;
+            QContactName name;
+            name.setFirstName(firstName);
+            contact.saveDetail(&name);
+            QVERIFY(manager.saveContact(&contact));
+            ids << contact.id();
+        }
+
+        QContactFetchByIdRequest firstReq;
+        firstReq.setManager(&manager);
+        firstReq.setIds(QList<QContactId>() << ids[0]);
+
+        QContactFetchByIdRequest secondReq;
+        secondReq.setManager(&manager);
+        secondReq.setIds(ids);
+
+        QContactFetchByIdRequest canceledReq;
+        canceledReq.setManager(&manager);
+        canceledReq.setIds(ids);
+
+        firstReq.start();
+        secondReq.start();
+        canceledReq.start();
+        canceledReq.cancel();
+
+        QTRY_COMPARE(firstReq.state(), QContactAbstractRequest::FinishedState);
+        QTRY_COMPARE(secondReq.state(), QContactAbstractRequest::FinishedState);
+        QCOMPARE(canceledReq.state(), QContactAbstractRequest::CanceledState);
+
+        QCOMPARE(firstReq.contacts().size(), 1);
+        QCOMPARE(firstReq.contacts()[0].id(), ids[0]);
+        QCOMPARE(secondReq.contacts().size(), 2);
+    }
 };
 
 QTEST_MAIN(QContactsAsyncRequestTest)
@@ -299,6 +299,133 @@ private Q_SLOTS:
                 QStringLiteral(""));
     }
 
+    /*
+     * Test fetch contacts by id with the client cache enabled
+     */
+    void testContactCache()
+    {
+        QMap<QString, QString> parameters;
+        parameters.insert(ADDRESS_BOOK_CACHE_SIZE_PROP, "10");
+        QContactManager cachedManager("galera", parameters);
+
+        QContact contact = testContact();
+        QSignalSpy spyContactAdded(&cachedManager, SIGNAL(contactsAdded(QList<QContactId>)));
+        QVERIFY(cachedManager.saveContact(&contact));
+        QTRY_COMPARE(spyContactAdded.count(), 1);
+
+        QContact cached = cachedManager.contact(contact.id());
+        QCOMPARE(cached.detail<QContactName>().lastName(), QStringLiteral("Tal"));
+        QCOMPARE(cachedManager.contacts(QList<QContactId>() << contact.id()).size(), 1);
+
+        // update the contact from other manager, the cache must be invalidated by the server notification
+        QContactName name = contact.detail<QContactName>();
+        name.setLastName("Silva");
+        contact.saveDetail(&name);
+
+        QSignalSpy spyContactChanged(&cachedManager, SIGNAL(contactsChanged(QList<QContactId>)));
+        QVERIFY(m_manager->saveContact(&contact));
+        QTRY_COMPARE(spyContactChanged.count(), 1);
+
+        cached = cachedManager.contact(contact.id());
+        QCOMPARE(cached.detail<QContactName>().lastName(), QStringLiteral("Silva"));
+    }
+
+    /*
+     * Test queries with results that fit in a single page
+     */
+    void testQueryWithMaxCountHint()
+    {
+        QSignalSpy spyContactAdded(m_manager, SIGNAL(contactsAdded(QList<QContactId>)));
+
+        QList<QContactId> ids;
+        Q_FOREACH(const QString &firstName, QStringList() << "Cc" << "Aa" << "Bb") {
+            QContact contact;
+            QContactName name;
+            name.setFirstName(firstName);
+            contact.saveDetail(&name);
+            QVERIFY(m_manager->saveContact(&contact));
+            ids << contact.id();
+        }
+        QTRY_VERIFY(spyContactAdded.count() > 0);
+
+        QContactSortOrder sortFirstName;
+        sortFirstName.setDetailType(QContactDetail::TypeName, QContactName::FieldFirstName);
+        sortFirstName.setDirection(Qt::AscendingOrder);
+
+        QContactFetchHint hint;
+        hint.setMaxCountHint(2);
+
+        QList<QContact> contacts = m_manager->contacts(QContactFilter(),
+                                                       QList<QContactSortOrder>() << sortFirstName,
+                                                       hint);
+        QCOMPARE(contacts.size(), 2);
+        QCOMPARE(contacts[0].detail<QContactName>().firstName(), QStringLiteral("Aa"));
+        QCOMPARE(contacts[1].detail<QContactName>().firstName(), QStringLiteral("Bb"));
+
+        // fetch by id
+        contacts = m_manager->contacts(ids.mid(0, 2));
+        QCOMPARE(contacts.size(), 2);
+        QList<QContactId> fetchedIds;
+        Q_FOREACH(const QContact &contact, contacts) {
+            fetchedIds << contact.id();
+        }
+        QVERIFY(fetchedIds.contains(ids[0]));
+        QVERIFY(fetchedIds.contains(ids[1]));
+    }
+
+    /*
+     * Test queries with results bigger than the first pages, the client requests
+     * two pages at time doubling the page size
+     */
+    void testQueryManyPages_data()
+    {
+        QTest::addColumn<int>("count");
+
+        // the second page is the short last page
+        QTest::newRow("short last page") << 60;
+        // the first two pages are full and the third one is empty
+        QTest::newRow("empty last page") << 75;
+    }
+
+    void testQueryManyPages()
+    {
+        QFETCH(int, count);
+        QSignalSpy spyContactAdded(m_manager, SIGNAL(contactsAdded(QList<QContactId>)));
+
+        // create the contacts in reverse order
+        QList<QContact> contacts;
+        for (int i = count - 1; i >= 0; i--) {
+            QContact contact;
+            QContactName name;
+            name.setFirstName(QString("Contact%1").arg(i, 3, 10, QChar('0')));
+            contact.saveDetail(&name);
+            contacts << contact;
+        }
+        QVERIFY(m_manager->saveContacts(&contacts));
+        QTRY_VERIFY(spyContactAdded.count() > 0);
+
+        QContactSortOrder sortFirstName;
+        sortFirstName.setDetailType(QContactDetail::TypeName, QContactName::FieldFirstName);
+        sortFirstName.setDirection(Qt::AscendingOrder);
+
+        QContactFetchRequest request;
+        request.setManager(m_manager);
+        request.setSorting(QList<QContactSortOrder>() << sortFirstName);
+        QSignalSpy spyResults(&request, SIGNAL(resultsAvailable()));
+        QVERIFY(request.start());
+        QTRY_COMPARE(request.state(), QContactAbstractRequest::FinishedState);
+
+        // the pages arrive in order and the last one finishes the request
+        QCOMPARE(request.error(), QContactManager::NoError);
+        QVERIFY(spyResults.count() > 1);
+        QList<QContact> result = request.contacts();
+        QCOMPARE(result.size(), count);
+        for (int i = 0; i < count; i++) {
+            QCOMPARE(result[i].detail<QContactName>().firstName(),
+                     QString("Contact%1").arg(i, 3, 10, QChar('0')));
+        }
+    }
+
     void testContactDisplayName()
     {
         // create a contact ""
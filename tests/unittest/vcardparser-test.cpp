@@ -24,8 +24,15 @@
 #include <QtContacts>
 
 #include "common/vcard-parser.h"
+#include "common/vcard-tokenizer.h"
+#include "common/vcard-writer.h"
+
+#include <QtVersit/QVersitContactExporter>
+#include <QtVersit/QVersitReader>
+#include <QtVersit/QVersitWriter>
 
 using namespace QtContacts;
+using namespace QtVersit;
 using namespace galera;
 
 typedef QList<QContact> QContactList;
@@ -425,6 +432,149 @@ private Q_SLOTS:
          QString vcard = VCardParser::contactToVcard(c);
          QVERIFY(vcard.contains("UID:11"));
      }
+
+    /*
+     * Test export of values that need to be escaped or folded
+     */
+    void testContactWithLongValuesToVCard()
+    {
+        QContact c = m_contacts[0];
+
+        QContactNote note;
+        note.setNote(QString("first line; with separators, and a backslash \\\nsecond line ").repeated(4));
+        c.saveDetail(&note);
+
+        QString vcard = VCardParser::contactToVcard(c);
+        QVERIFY(vcard.startsWith("BEGIN:VCARD\r\nVERSION:3.0\r\n"));
+        QVERIFY(vcard.endsWith("END:VCARD\r\n"));
+        Q_FOREACH(const QString &line, vcard.split("\r\n")) {
+            QVERIFY(line.size() <= 76);
+        }
+
+        // the value must be the same after import the vcard again
+        QContact imported = VCardParser::vcardToContact(vcard);
+        compareContact(imported, c);
+        QCOMPARE(imported.detail<QContactNote>().note(), note.note());
+    }
+
+    /*
+     * Test tokenize folded lines, parameters and compound values
+     */
+    /*
+     * Test if VCardWriter writes the same bytes of QVersitWriter
+     */
+    void testVCardWriterOutput()
+    {
+        QContact longContact = m_contacts[0];
+        QContactNote note;
+        note.setNote(QString("first line; with separators, and a backslash \\\r\nsecond line \u00e1\u00e9 ").repeated(4));
+        longContact.saveDetail(&note);
+
+        QVersitContactExporter exporter;
+        QVERIFY(exporter.exportContacts(QList<QContact>() << m_contacts << longContact,
+                                        QVersitDocument::VCard30Type));
+        QList<QVersitDocument> documents = exporter.documents();
+
+        // documents with the parameters of the fixtures
+        QVersitReader reader(m_vcards.join("").toUtf8());
+        QVERIFY(reader.startReading());
+        QVERIFY(reader.waitForFinished());
+        documents << reader.results();
+
+        QVersitProperty property;
+        property.setName("X-TEST");
+        property.insertParameter("TYPE", "a;b");
+        property.insertParameter("TYPE", "c,d");
+        property.setValue(QStringList() << "first" << "" << "third");
+        property.setValueType(QVersitProperty::ListType);
+        QVersitDocument document(QVersitDocument::VCard30Type);
+        document.setComponentType("VCARD");
+        document.addProperty(property);
+        documents << document;
+
+        QByteArray expected;
+        QVersitWriter writer(&expected);
+        QVERIFY(writer.startWriting(documents));
+        QVERIFY(writer.waitForFinished());
+
+        VCardWriter vcardWriter;
+        QCOMPARE(vcardWriter.write(documents).join("").toUtf8(), expected);
+
+        // the tokenizer reads the written documents back
+        QList<QVersitDocument> parsed = VCardTokenizer::parse(vcardWriter.write(document));
+        QCOMPARE(parsed.size(), 1);
+        QVersitProperty parsedProperty = parsed[0].properties().first();
+        QCOMPARE(parsedProperty.parameters().values("TYPE").toSet(), QSet<QString>() << "a;b" << "c,d");
+        QCOMPARE(parsedProperty.variantValue().toStringList(), QStringList() << "first" << "third");
+    }
+
+    void testTokenizeVCard()
+    {
+        QString vcard("BEGIN:VCARD\r\n"
+                      "VERSION:3.0\r\n"
+                      "N:Last\\;Name;First;;;\r\n"
+                      "item1.TEL;TYPE=CELL,VOICE;PID=\"1.1\";PREF=1:+55 81\r\n"
+                      " 8888 7777\r\n"
+                      "NOTE:first\\, line\\nsecond line\r\n"
+                      "PHOTO;ENCODING=b;TYPE=PNG:YWJj\r\n"
+                      "END:VCARD\r\n");
+
+        QList<QVersitDocument> documents = VCardTokenizer::parse(QStringList() << vcard << vcard);
+        QCOMPARE(documents.size(), 2);
+
+        QVersitDocument document = documents.at(0);
+        QCOMPARE(document.type(), QVersitDocument::VCard30Type);
+        QCOMPARE(document.componentType(), QString("VCARD"));
+        QCOMPARE(document.properties().size(), 4);
+
+        QVersitProperty name = document.properties().at(0);
+        QCOMPARE(name.name(), QString("N"));
+        QCOMPARE(name.value<QStringList>(), QStringList() << "Last;Name" << "First" << "" << "" << "");
+
+        QVersitProperty phone = document.properties().at(1);
+        QCOMPARE(phone.groups(), QStringList() << "item1");
+        QCOMPARE(phone.name(), QString("TEL"));
+        QCOMPARE(phone.value(), QString("+55 818888 7777"));
+        QCOMPARE(phone.parameters().values("TYPE").size(), 2);
+        QVERIFY(phone.parameters().contains("TYPE", "CELL"));
+        QVERIFY(phone.parameters().contains("TYPE", "VOICE"));
+        QCOMPARE(phone.parameters().value("PID"), QString("1.1"));
+        QCOMPARE(phone.parameters().value("PREF"), QString("1"));
+
+        QCOMPARE(document.properties().at(2).value(), QString("first, line\nsecond line"));
+
+        QVersitProperty photo = document.properties().at(3);
+        QCOMPARE(photo.value<QByteArray>(), QByteArray("abc"));
+        QVERIFY(!photo.parameters().contains("ENCODING"));
+    }
+
+    void testVCardFromOtherClients()
+    {
+        // vCards that are not written by the service are read by QVersitReader
+        QStringList vcards;
+        vcards << QStringLiteral("BEGIN:VCARD\r\n"
+                                 "VERSION:3.0\r\n"
+                                 "N:Gump;Forrest;;;\r\n"
+                                 "END:VCARD\r\n")
+               << QStringLiteral("BEGIN:VCARD\r\n"
+                                 "VERSION:2.1\r\n"
+                                 "N:Gump;Penny;;;\r\n"
+                                 "NOTE;ENCODING=QUOTED-PRINTABLE:first=0D=0Asecond\r\n"
+                                 "END:VCARD\r\n")
+               << QStringLiteral("BEGIN:VCARD\r\n"
+                                 "VERSION:3.0\r\n"
+                                 "N;CHARSET=UTF-8:Tal;Fulano;;;\r\n"
+                                 "END:VCARD\r\n");
+
+        // the contacts keep the vCards order
+        QList<QContact> contacts = VCardParser::vcardToContactSync(vcards);
+        QCOMPARE(contacts.size(), 3);
+        QCOMPARE(contacts[0].detail<QContactName>().lastName(), QStringLiteral("Gump"));
+        QCOMPARE(contacts[1].detail<QContactName>().firstName(), QStringLiteral("Penny"));
+        QCOMPARE(contacts[1].detail<QContactNote>().note(), QStringLiteral("first\r\nsecond"));
+        QCOMPARE(contacts[2].detail<QContactName>().lastName(), QStringLiteral("Tal"));
+        QCOMPARE(contacts[2].detail<QContactName>().firstName(), QStringLiteral("Fulano"));
+    }
 };
 
 QTEST_MAIN(VCardParseTest)